@@ -4,10 +4,32 @@
 /	Mint Luc
 /	Bowie Gian
 /	Created: 2023-06-30
-/	Modified: 2023-11-19
+/	Modified: 2026-10-17
 /
 /	This file contains the functions that will drive the accelerometer.
 /	The SPI setup is modified from the accelerometer example.
+/
+/	With FIXED_POINT_ANGLE set the angles are computed from the raw counts
+/	with CORDIC in fixed point, the double path is kept for comparison.
+/
+/	The ADXL343 samples at 400 Hz into its 32 entry FIFO in stream mode and
+/	raises INT1 when FIFO_WATERMARK samples are waiting. The INT1 interrupt
+/	notes the time and starts a chain of SPI DMA transfers, each one started
+/	from the previous one's interrupt: FIFO_STATUS, then a 6 byte burst of
+/	the data registers per entry. Every sample goes into a queue with the
+/	time it was taken, worked back from the INT1 edge, and Accel_poll()
+/	feeds the queue to the angle filter. The queue has a single producer
+/	(the interrupts) and a single consumer (Accel_poll) like the LIDAR ring.
+/
+/	The angle filter averages the raw acceleration vector rather than the
+/	angles, so it doesn't break where atan2 wraps at +-180 degrees, and the
+/	angles are only worked out once per poll from the averaged vector. The
+/	window keeps running sums of the raw counts, each sample adds the new
+/	one and subtracts the one leaving, so a sample costs the same for any
+/	window length. The sums are integers and never drift.
+/	Every sample also goes to the attitude estimator (attitude.c), and
+/	Accel_setFilter() picks which of the two the angles come from.
+/	With the capture on (capture.c) the raw samples are copied out too.
 / ----------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------*/
@@ -16,31 +38,72 @@
 
 #include <stdio.h>
 #include <math.h>
-#include "pico/stdio.h"
-#include "pico/stdlib.h"
-#include "hardware/spi.h"
+#include "hal.h"
 #include "accelerometer.h"
+#include "attitude.h"
+#include "capture.h"
+#include "fixmath.h"
 
 /*--------------------------------------------------------------*/
 /* Definitions													*/
 /*--------------------------------------------------------------*/
 
-#define DEBUG 0
+// 1 to compute the angles in fixed point, 0 for the double path
+#define FIXED_POINT_ANGLE 1
 
 // Pins
 #define CS_PIN 13
 #define SCK_PIN 14
 #define MOSI_PIN 15
 #define MISO_PIN 12
+#define INT1_PIN 10
 
 // Registers
 #define REG_DEVID 0x00
+#define REG_BW_RATE 0x2C
 #define REG_POWER_CTL 0x2D
+#define REG_INT_ENABLE 0x2E
+#define REG_INT_MAP 0x2F
 #define REG_DATAX0 0x32
+#define REG_FIFO_CTL 0x38
+#define REG_FIFO_STATUS 0x39
 
 #define DEVID 0xE5
 
-#define AVERAGING_SIZE 5
+// Output data rate code, 0x0C is 400 Hz (the default 0x0A is 100 Hz)
+#define RATE_400HZ 0x0C
+#define SAMPLE_PERIOD_US 2500
+
+// FIFO
+#define FIFO_DEPTH 32
+#define FIFO_BYPASS 0
+#define FIFO_STREAM (2 << 6)
+#define FIFO_WATERMARK 4			// Samples per INT1, every 10 ms
+#define FIFO_ENTRIES_MASK 0x3F
+#define WATERMARK_BIT (1 << 1)
+
+// SPI read command bits
+#define READ_BIT 0x80
+#define MULTI_BYTE_BIT 0x40
+
+// 320 ms at 400 Hz, must be a power of 2
+#define QUEUE_SIZE 128
+#define QUEUE_MASK (QUEUE_SIZE - 1)
+
+// Angle window, 1.28 s at 400 Hz, must be a power of 2
+// Counts are 10 bit (+-2 g), so the sums of a full window fit 19 bits
+#define WINDOW_MAX 512
+#define WINDOW_MASK (WINDOW_MAX - 1)
+#define WINDOW_DEFAULT 16			// 40 ms at 400 Hz
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	uint8_t data[6];		// DATAX0 to DATAZ1
+	uint64_t timeUs;
+} Sample;
 
 /*--------------------------------------------------------------*/
 /* Global Variables				 								*/
@@ -51,25 +114,48 @@ static const float SENSITIVITY_2G = 1.0 / 256;	// (g/LSB)
 static const float EARTH_GRAVITY = 9.80665;		// Earth's gravity in [m/s^2]
 
 // Ports
-static spi_inst_t *spi = spi1;
+static const HalSpi spi = HAL_SPI1;
 
 // Angle output
 static Angle angles;
-
-static double thetaBuff[AVERAGING_SIZE] = {0};
-static int thetaIndex = 0;
-static bool isThetaInit = false;
-
-static double alphaBuff[AVERAGING_SIZE] = {0};
-static int alphaIndex = 0;
-static bool isAlphaInit = false;
+static AccelFilter filter = ACCEL_FILTER_KALMAN;
+static Attitude attitude;
+
+// Newest WINDOW_MAX samples, the newest windowSize of them are summed
+static int16_t window[WINDOW_MAX][3];
+static uint32_t windowHead = 0;
+static int numStored = 0;
+static int windowSize = WINDOW_DEFAULT;
+static int32_t windowSum[3] = {0};
+
+// Written by the interrupts only
+static Sample queue[QUEUE_SIZE];
+static volatile uint32_t queueHead = 0;
+static volatile uint32_t numOverflows = 0;
+static volatile uint32_t numDropped = 0;
+static void (*sampleCallback)(void) = NULL;
+
+// Written by Accel_poll only
+static volatile uint32_t queueTail = 0;
+static uint32_t lastOverflows = 0;
+static uint32_t lastDropped = 0;
+static uint64_t sampleTimeUs = 0;
+
+// FIFO drain, owned by the interrupts while isDraining is set
+static volatile bool isDraining = false;
+static uint64_t watermarkUs;
+static int numEntries;
+static int numRead;
+static const uint8_t statusTx[2] = {READ_BIT | REG_FIFO_STATUS, 0};
+static const uint8_t dataTx[7] = {READ_BIT | MULTI_BYTE_BIT | REG_DATAX0};
+static uint8_t rxBuffer[7];
 
 /*--------------------------------------------------------------*/
 /*  Static Function Implemetations								*/
 /*--------------------------------------------------------------*/
 
 // Write 1 byte to the specified register
-static void reg_write(	spi_inst_t *spi, const uint cs,
+static void reg_write(	HalSpi spi, const uint32_t cs,
 						const uint8_t reg, const uint8_t data)
 {
 	uint8_t msg[2];
@@ -79,14 +165,14 @@ static void reg_write(	spi_inst_t *spi, const uint cs,
 	msg[1] = data;
 
 	// Write to register
-	gpio_put(cs, 0);
-	spi_write_blocking(spi, msg, 2);
-	gpio_put(cs, 1);
+	Hal_gpioPut(cs, 0);
+	Hal_spiWrite(spi, msg, 2);
+	Hal_gpioPut(cs, 1);
 }
 
 // Read byte(s) from specified register. If nbytes > 1, read from consecutive
 // registers.
-static int reg_read(spi_inst_t *spi, const uint cs, const uint8_t reg,
+static int reg_read(HalSpi spi, const uint32_t cs, const uint8_t reg,
 					uint8_t *buf, const uint8_t nbytes)
 {
 	int num_bytes_read = 0;
@@ -105,76 +191,195 @@ static int reg_read(spi_inst_t *spi, const uint cs, const uint8_t reg,
 	uint8_t msg = 0x80 | (mb << 6) | reg;
 
 	// Read from register
-	gpio_put(cs, 0);
-	spi_write_blocking(spi, &msg, 1);
-	num_bytes_read = spi_read_blocking(spi, 0, buf, nbytes);
-	gpio_put(cs, 1);
+	Hal_gpioPut(cs, 0);
+	Hal_spiWrite(spi, &msg, 1);
+	num_bytes_read = Hal_spiRead(spi, 0, buf, nbytes);
+	Hal_gpioPut(cs, 1);
 
 	return num_bytes_read;
 }
 
-// Inputs the next value and returns the new average
-static double movingAverage(double value, double buffer[], int *pIndex, bool *pIsInit) {
-	if (!*pIsInit) {
-		*pIsInit = true;
+// Number of samples in the window average
+static int windowCount()
+{
+	return numStored < windowSize ? numStored : windowSize;
+}
 
-		for (int i = 0; i < AVERAGING_SIZE; i++) {
-			buffer[i] = value;
-		}
-		return value;
+#if FIXED_POINT_ANGLE == 0
+// Angles of the averaged vector, x, y and z are sums of n samples
+static Angle cal_Angle(double x, double y, double z, int n) {
+	Angle result_angle;
+
+	result_angle.r = sqrt(x*x + y*y + z*z) / n;
+	result_angle.theta = atan2(y, sqrt(x * x + z * z)) * 180/M_PI;
+	result_angle.alpha = atan2(x, -z) * 180/M_PI;
+
+	return result_angle;
+}
+#else
+// Same as cal_Angle, on the raw count sums and without floating point
+static Angle cal_AngleFixed(int32_t x, int32_t y, int32_t z, int n) {
+	Angle result_angle;
+
+	// Up to 3 * 2^36, fits with 16 more bits
+	uint64_t sum_xz = (uint64_t)((int64_t)x * x) + (uint64_t)((int64_t)z * z);
+	uint64_t sum_r = sum_xz + (uint64_t)((int64_t)y * y);
+
+	// Magnitudes in counts with 8 fractional bits
+	uint32_t r = Fix16_isqrt(sum_r << 16);
+	int32_t xz = (int32_t)Fix16_isqrt(sum_xz << 16);
+
+	result_angle.r = r / 256.0 / n * SENSITIVITY_2G * EARTH_GRAVITY;
+	result_angle.theta = Fix16_toDouble(Fix16_atan2Deg(y * 256, xz));
+	result_angle.alpha = Fix16_toDouble(Fix16_atan2Deg(x, -z));
+
+	return result_angle;
+}
+#endif
+
+// Works the angles out from the window sums or the attitude estimate
+static void updateAngles()
+{
+	int32_t sum[3];
+	int n = windowCount();
+
+	if (n == 0) {
+		return;
 	}
 
-	if (*pIndex < AVERAGING_SIZE - 1) {
-		*pIndex += 1;
+	if (filter == ACCEL_FILTER_AVERAGE) {
+		for (int i = 0; i < 3; i++) {
+			sum[i] = windowSum[i];
+		}
 	} else {
-		*pIndex = 0;
+		// 8 fractional bits, the same as a sum of 256 samples
+		Attitude_getGravity(&attitude, sum);
+		n = 256;
 	}
 
-	buffer[*pIndex] = value;
+#if FIXED_POINT_ANGLE == 1
+	angles = cal_AngleFixed(sum[0], sum[1], sum[2], n);
+#else
+	// Convert the sums to [m/s^2]
+	double scale = SENSITIVITY_2G * EARTH_GRAVITY;
+	angles = cal_Angle(sum[0] * scale, sum[1] * scale, sum[2] * scale, n);
+#endif
 
-	double sum = 0.0;
+	//printf("r: %.2f | theta: %.2f | alpha: %.2f\r\n", angles.r, angles.theta, angles.alpha);
+}
 
-#if DEBUG == 1
-	printf("[ ");
-#endif
-	for (int i = 0; i < AVERAGING_SIZE; i++) {
-		sum += buffer[i];
-#if DEBUG == 1
-		printf("%lf ", buffer[i]);
-#endif
+// Adds one raw sample to the window and the attitude estimate
+static void addSample(const uint8_t data[6], uint64_t timeUs)
+{
+	uint32_t head = windowHead;
+
+	// The sample leaving the window, still stored when the window is full
+	if (numStored >= windowSize) {
+		const int16_t *oldest = window[(head - windowSize) & WINDOW_MASK];
+		for (int i = 0; i < 3; i++) {
+			windowSum[i] -= oldest[i];
+		}
 	}
 
-	double average = sum / (double)AVERAGING_SIZE;
-#if DEBUG == 1
-	printf("] Avg: %lf\n", average);
-#endif
-	return average;
+	// Convert 2 bytes (little-endian) into 16-bit integer (signed)
+	for (int i = 0; i < 3; i++) {
+		window[head][i] = (int16_t)((data[2*i + 1] << 8) | data[2*i]);
+		windowSum[i] += window[head][i];
+	}
+
+	Attitude_addAccel(&attitude, window[head], timeUs);
+
+	windowHead = (head + 1) & WINDOW_MASK;
+	if (numStored < WINDOW_MAX) {
+		numStored++;
+	}
 }
 
-static double movAvgTheta(double value) {
-	return movingAverage(value, thetaBuff, &thetaIndex, &isThetaInit);
+static void startDrain(uint64_t timeUs);
+static void onEntryRead();
+
+// Below 1.5 MHz the address byte gives the FIFO the 5 us it needs to pop
+static void readNextEntry()
+{
+	Hal_gpioPut(CS_PIN, 0);
+	Hal_spiTransferDma(spi, dataTx, rxBuffer, sizeof(dataTx), onEntryRead);
 }
 
-static double movAvgAlpha(double value) {
-	return movingAverage(value, alphaBuff, &alphaIndex, &isAlphaInit);
+static void finishDrain()
+{
+	isDraining = false;
+
+	if (numRead > 0 && sampleCallback) {
+		sampleCallback();
+	}
+
+	// The watermark was reached again mid drain, INT1 never went low
+	if (Hal_gpioGet(INT1_PIN)) {
+		startDrain(Hal_timeUs());
+	}
 }
 
-// Limitation: Averaging doesn't work when optic is upside down
-// due to fluctuations near 180 and -180
-static Angle cal_Angle(double x, double y, double z) {
-	double sum_r, r, theta, alpha;
-	Angle result_angle;
+static void onEntryRead()
+{
+	uint32_t head = queueHead;
+	uint32_t next = (head + 1) & QUEUE_MASK;
 
-	sum_r =  x*x + y*y + z*z;
-	result_angle.r = sqrt(sum_r);
+	Hal_gpioPut(CS_PIN, 1);
 
-	theta = atan2(y, sqrt(x * x + z * z)) * 180/M_PI;
-	result_angle.theta = movAvgTheta(theta);
+	if (next == __atomic_load_n(&queueTail, __ATOMIC_ACQUIRE)) {
+		numDropped++;
+	} else {
+		for (int i = 0; i < 6; i++) {
+			queue[head].data[i] = rxBuffer[1 + i];
+		}
 
-	alpha = atan2(x, -z) * 180/M_PI;
-	result_angle.alpha = movAvgAlpha(alpha);
+		// Entry FIFO_WATERMARK - 1 is the one that raised INT1
+		queue[head].timeUs = watermarkUs
+				+ (int64_t)(numRead - (FIFO_WATERMARK - 1)) * SAMPLE_PERIOD_US;
+		__atomic_store_n(&queueHead, next, __ATOMIC_RELEASE);
+	}
 
-	return result_angle; 
+	if (++numRead < numEntries) {
+		readNextEntry();
+	} else {
+		finishDrain();
+	}
+}
+
+static void onStatusRead()
+{
+	Hal_gpioPut(CS_PIN, 1);
+
+	numEntries = rxBuffer[1] & FIFO_ENTRIES_MASK;
+	numRead = 0;
+
+	// A full FIFO has most likely dropped samples
+	if (numEntries >= FIFO_DEPTH) {
+		numOverflows++;
+	}
+
+	if (numEntries > 0) {
+		readNextEntry();
+	} else {
+		finishDrain();
+	}
+}
+
+static void startDrain(uint64_t timeUs)
+{
+	isDraining = true;
+	watermarkUs = timeUs;
+
+	Hal_gpioPut(CS_PIN, 0);
+	Hal_spiTransferDma(spi, statusTx, rxBuffer, sizeof(statusTx), onStatusRead);
+}
+
+// INT1 rises as the FIFO reaches the watermark
+static void onInt1()
+{
+	if (!isDraining) {
+		startDrain(Hal_timeUs());
+	}
 }
 
 /*--------------------------------------------------------------*/
@@ -187,27 +392,29 @@ void Accel_setup()
 	uint8_t data[6];
 
 	// Initialize chosen serial port
-	stdio_init_all();
+	Hal_init();
+
+	Attitude_init(&attitude, filter == ACCEL_FILTER_COMPLEMENTARY
+			? ATTITUDE_COMPLEMENTARY : ATTITUDE_KALMAN);
 
 	// Initialize CS pin high
-	gpio_init(CS_PIN);
-	gpio_set_dir(CS_PIN, GPIO_OUT);
-	gpio_put(CS_PIN, 1);
+	Hal_gpioInit(CS_PIN);
+	Hal_gpioSetDir(CS_PIN, HAL_GPIO_OUT);
+	Hal_gpioPut(CS_PIN, 1);
 
 	// Initialize SPI port at 1 MHz
-	spi_init(spi, 1000 * 1000);
+	Hal_spiInit(spi, 1000 * 1000);
 
-	// Set SPI format
-	spi_set_format(	spi1,	// SPI instance
-					8,		// Number of bits per transfer
-					1,		// Polarity (CPOL)
-					1,		// Phase (CPHA)
-					SPI_MSB_FIRST);
+	// Set SPI format (MSB first)
+	Hal_spiSetFormat(	spi,	// SPI instance
+						8,		// Number of bits per transfer
+						1,		// Polarity (CPOL)
+						1);		// Phase (CPHA)
 
 	// Initialize SPI pins
-	gpio_set_function(SCK_PIN, GPIO_FUNC_SPI);
-	gpio_set_function(MOSI_PIN, GPIO_FUNC_SPI);
-	gpio_set_function(MISO_PIN, GPIO_FUNC_SPI);
+	Hal_gpioSetFunction(SCK_PIN, HAL_GPIO_FUNC_SPI);
+	Hal_gpioSetFunction(MOSI_PIN, HAL_GPIO_FUNC_SPI);
+	Hal_gpioSetFunction(MISO_PIN, HAL_GPIO_FUNC_SPI);
 
 	// Workaround: perform throw-away read to make SCK idle high
 	reg_read(spi, CS_PIN, REG_DEVID, data, 1);
@@ -219,6 +426,13 @@ void Accel_setup()
 		while (true);
 	}
 
+	// Sample at 400 Hz into the FIFO, keeping the newest 32, and raise INT1
+	// at the watermark
+	reg_write(spi, CS_PIN, REG_BW_RATE, RATE_400HZ);
+	reg_write(spi, CS_PIN, REG_FIFO_CTL, FIFO_STREAM | FIFO_WATERMARK);
+	reg_write(spi, CS_PIN, REG_INT_MAP, 0);
+	reg_write(spi, CS_PIN, REG_INT_ENABLE, WATERMARK_BIT);
+
 	// Read Power Control register
 	reg_read(spi, CS_PIN, REG_POWER_CTL, data, 1);
 	printf("0x%X\r\n", data[0]);
@@ -232,35 +446,118 @@ void Accel_setup()
 	printf("0x%X\r\n", data[0]);
 
 	// Wait before taking measurements
-	sleep_ms(2000);
+	Hal_sleepMs(2000);
+
+	// Empty the FIFO so INT1 is low and the first watermark gives an edge
+	reg_write(spi, CS_PIN, REG_FIFO_CTL, FIFO_BYPASS);
+	reg_write(spi, CS_PIN, REG_FIFO_CTL, FIFO_STREAM | FIFO_WATERMARK);
+
+	// The SPI belongs to the interrupts from here on
+	Hal_gpioInit(INT1_PIN);
+	Hal_gpioSetDir(INT1_PIN, HAL_GPIO_IN);
+	Hal_gpioSetRiseIrq(INT1_PIN, onInt1);
 }
 
 void Accel_poll()
 {
-	// Buffer to store raw reads
-	uint8_t data[6];
+	uint32_t head = __atomic_load_n(&queueHead, __ATOMIC_ACQUIRE);
+	uint32_t tail = queueTail;
+
+	if (tail != head) {
+		while (tail != head) {
+			addSample(queue[tail].data, queue[tail].timeUs);
+			Capture_accelSample(queue[tail].data, (uint32_t)queue[tail].timeUs);
+			sampleTimeUs = queue[tail].timeUs;
+			tail = (tail + 1) & QUEUE_MASK;
+		}
+		Capture_flush();
+		__atomic_store_n(&queueTail, tail, __ATOMIC_RELEASE);
+		updateAngles();
+	}
 
-	// Read X, Y, and Z values from registers (16 bits each)
-	reg_read(spi, CS_PIN, REG_DATAX0, data, 6);
+	if (numOverflows != lastOverflows) {
+		printf("ADXL343 FIFO overflow %u\r\n", (unsigned)(numOverflows - lastOverflows));
+		lastOverflows = numOverflows;
+	}
+	if (numDropped != lastDropped) {
+		printf("Accelerometer queue overflow %u\r\n", (unsigned)(numDropped - lastDropped));
+		lastDropped = numDropped;
+	}
+}
 
-	// Convert 2 bytes (little-endian) into 16-bit integer (signed)
-	int16_t acc_x = (int16_t)((data[1] << 8) | data[0]);
-	int16_t acc_y = (int16_t)((data[3] << 8) | data[2]);
-	int16_t acc_z = (int16_t)((data[5] << 8) | data[4]);
+Angle Accel_getAngle()
+{
+	return angles;
+}
 
-	// Convert measurements to [m/s^2]
-	float acc_x_f = acc_x * SENSITIVITY_2G * EARTH_GRAVITY;
-	float acc_y_f = acc_y * SENSITIVITY_2G * EARTH_GRAVITY;
-	float acc_z_f = acc_z * SENSITIVITY_2G * EARTH_GRAVITY;
+uint64_t Accel_getSampleTimeUs()
+{
+	return sampleTimeUs;
+}
 
-	// Print results
-	//printf("X: %.2f | Y: %.2f | Z: %.2f\r\n", acc_x_f, acc_y_f, acc_z_f);
-	angles = cal_Angle(acc_x_f, acc_y_f, acc_z_f);
+void Accel_getSample(int16_t sample[3])
+{
+	const int16_t *newest = window[(windowHead - 1) & WINDOW_MASK];
 
-	//printf("r: %.2f | theta: %.2f | alpha: %.2f\r\n", angles.r, angles.theta, angles.alpha);
+	for (int i = 0; i < 3; i++) {
+		sample[i] = numStored > 0 ? newest[i] : 0;
+	}
 }
 
-Angle Accel_getAngle()
+uint32_t Accel_getOverflowCount()
 {
-	return angles;
+	return numOverflows;
+}
+
+void Accel_setSampleCallback(void (*callback)(void))
+{
+	sampleCallback = callback;
+}
+
+void Accel_setWindow(int size)
+{
+	if (size < 1) {
+		size = 1;
+	} else if (size > WINDOW_MAX) {
+		size = WINDOW_MAX;
+	}
+
+	// Only a resize sums the whole window
+	windowSize = size;
+	for (int i = 0; i < 3; i++) {
+		windowSum[i] = 0;
+	}
+	for (int n = 1; n <= windowCount(); n++) {
+		const int16_t *sample = window[(windowHead - n) & WINDOW_MASK];
+		for (int i = 0; i < 3; i++) {
+			windowSum[i] += sample[i];
+		}
+	}
+	updateAngles();
+}
+
+int Accel_getWindow()
+{
+	return windowSize;
+}
+
+void Accel_setFilter(AccelFilter newFilter)
+{
+	// The estimate restarts from the next sample
+	if (newFilter != filter && newFilter != ACCEL_FILTER_AVERAGE) {
+		Attitude_init(&attitude, newFilter == ACCEL_FILTER_COMPLEMENTARY
+				? ATTITUDE_COMPLEMENTARY : ATTITUDE_KALMAN);
+	}
+	filter = newFilter;
+	updateAngles();
+}
+
+AccelFilter Accel_getFilter()
+{
+	return filter;
+}
+
+void Accel_addGyro(const fix16 rate_dps[3], uint64_t timeUs)
+{
+	Attitude_addGyro(&attitude, rate_dps, timeUs);
 }
@@ -4,7 +4,7 @@
 /	Mint Luc
 /	Bowie Gian
 /	Created: 2023-06-30
-/	Modified: 2023-07-28
+/	Modified: 2026-10-17
 /
 /	This file contains the function declarations
 /	for operating the accelerometer.
@@ -12,6 +12,19 @@
 #ifndef ACCELEROMETER_H
 #define ACCELEROMETER_H
 
+#include <stdint.h>
+#include "fixmath.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+typedef enum {
+	ACCEL_FILTER_AVERAGE,			// Window average (Accel_setWindow())
+	ACCEL_FILTER_COMPLEMENTARY,		// Attitude estimator, see attitude.h
+	ACCEL_FILTER_KALMAN
+} AccelFilter;
+
 /*--------------------------------------------------------------*/
 /* Structs														*/
 /*--------------------------------------------------------------*/
@@ -27,7 +40,38 @@ typedef struct {
 /*--------------------------------------------------------------*/
 
 void Accel_setup();
+
+// Feeds every queued sample to the angle filters, never blocks
+// Must be called at least every 320 ms or samples are lost
 void Accel_poll();
+
 Angle Accel_getAngle();
 
+// When the newest sample in the filters was taken (Hal_timeUs())
+uint64_t Accel_getSampleTimeUs();
+
+// The newest raw sample in counts (256 per g), zero before the first
+void Accel_getSample(int16_t sample[3]);
+
+// Number of times the FIFO filled up and dropped samples
+uint32_t Accel_getOverflowCount();
+
+// Calls callback from the interrupt each time new samples are queued
+void Accel_setSampleCallback(void (*callback)(void));
+
+// Sets how many of the newest samples the angles are averaged over,
+// clamped to 1 - 512 (2.5 ms - 1.28 s), 16 by default
+void Accel_setWindow(int size);
+
+int Accel_getWindow();
+
+// Picks where the angles come from, the Kalman filter by default
+void Accel_setFilter(AccelFilter filter);
+
+AccelFilter Accel_getFilter();
+
+// Passes a gyro sample (degrees/s about the accelerometer's axes) to the
+// attitude estimator, call from the same core as Accel_poll()
+void Accel_addGyro(const fix16 rate_dps[3], uint64_t timeUs);
+
 #endif
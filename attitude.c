@@ -0,0 +1,280 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - attitude.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the attitude estimator.
+/
+/	The state is the gravity vector in counts rather than angles, so there
+/	is nothing to wrap at +-180 degrees. Each accelerometer sample pulls the
+/	estimate towards itself by a gain. The sample's variance grows with how
+/	far its magnitude is from 1 g, which shrinks the gain for recoil and
+/	handling shocks. The complementary filter uses a fixed gain (a time
+/	constant). The Kalman filter works the gain out from the estimate's
+/	variance, which grows a little every sample and jumps up when the
+/	samples keep disagreeing by far more than the noise, so a real change
+/	of aim settles quickly while a still rifle gets heavy smoothing.
+/	A gyro sample turns the estimate by the rate times the time since the
+/	last one, after which the accelerometer only has to correct the drift.
+/	The turn that is left between the estimate and the accelerometer is
+/	also fed back slowly into an estimate of the gyro's offset, like the
+/	integral term of a PI controller, so a biased gyro doesn't leave the
+/	angles off by its bias times the time constant. It only learns while
+/	the rifle is nearly still, when the error can't come from the turn.
+/	Everything is integer, the M0+ has no FPU.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include "attitude.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define ONE_G_COUNTS 256
+#define GYRO_TIMEOUT_US 50000
+
+// Sample noise of the ADXL343 at 400 Hz in counts^2
+#define NOISE_VAR ((fix16)(4 * FIX16_ONE))
+
+// Magnitude errors above this (0.5 g) all count the same
+#define MAX_SHOCK_COUNTS 128
+
+// Keeps the variances and their sum in range
+#define MAX_VAR ((fix16)(8192 * FIX16_ONE))
+
+// Complementary gain per sample, time constants of 0.1 s and 0.5 s at 400 Hz
+#define GAIN ((fix16)(0.025 * FIX16_ONE))
+#define GAIN_GYRO ((fix16)(0.005 * FIX16_ONE))
+
+// Kalman process noise per sample in counts^2, steady gains of about 0.01
+// and 0.0035 (time constants of 0.25 s and 0.7 s)
+#define PROCESS_VAR ((fix16)(0.0004 * FIX16_ONE))
+#define PROCESS_VAR_GYRO ((fix16)(0.00005 * FIX16_ONE))
+
+// This many samples in a row that are close to 1 g but this many standard
+// deviations off mean the aim really moved, a shock can pass through 1 g
+// for a sample or two on its way
+#define MANEUVER_SIGMAS 2
+#define MANEUVER_SAMPLES 3
+#define MANEUVER_MAX_VAR (NOISE_VAR + (fix16)(16 * 16 * FIX16_ONE))
+
+// Gyro offset correction per sample for each degree of error, about a
+// 0.6 s time constant with GAIN_GYRO, slower gets too little of a bias
+// learned before the first shot
+#define BIAS_GAIN ((fix16)(0.008 * FIX16_ONE))
+#define RAD_TO_DEG ((fix16)(57.29578 * FIX16_ONE))
+#define BIAS_MAX_RATE ((fix16)(10 * FIX16_ONE))
+
+// Gyro degrees/s (16 fractional bits) times microseconds to radians
+// (24 fractional bits) after a 32 bit shift, pi / 180 / 10^6 * 2^40
+#define DPS_US_TO_RAD 19191LL
+#define ANGLE_BITS 24
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+// a x b, a in any scale and b in radians with ANGLE_BITS fractional bits
+static void cross(const int32_t a[3], const int32_t b[3], int32_t result[3])
+{
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+		int64_t product = (int64_t)a[j] * b[k] - (int64_t)a[k] * b[j];
+
+		result[i] = (int32_t)((product + (1 << (ANGLE_BITS - 1))) >> ANGLE_BITS);
+	}
+}
+
+static bool hasGyro(const Attitude *attitude, uint64_t timeUs)
+{
+	return attitude->gyroUs != 0
+			&& (int64_t)(timeUs - attitude->gyroUs) < GYRO_TIMEOUT_US;
+}
+
+// Variance of a sample from its magnitude
+static fix16 sampleVariance(const int16_t accel[3])
+{
+	uint64_t sum = 0;
+
+	for (int i = 0; i < 3; i++) {
+		sum += (uint64_t)((int32_t)accel[i] * accel[i]);
+	}
+
+	int32_t shock = (int32_t)Fix16_isqrt(sum) - ONE_G_COUNTS;
+	if (shock < 0)
+		shock = -shock;
+	if (shock > MAX_SHOCK_COUNTS)
+		shock = MAX_SHOCK_COUNTS;
+
+	return NOISE_VAR + Fix16_fromInt(shock * shock);
+}
+
+static fix16 kalmanGain(Attitude *attitude, const int32_t error[3],
+		fix16 sampleVar, bool isGyro)
+{
+	fix16 variance = attitude->variance + (isGyro ? PROCESS_VAR_GYRO : PROCESS_VAR);
+
+	// Mean squared error per axis, whole counts are plenty here
+	int64_t errorSq = 0;
+	for (int i = 0; i < 3; i++) {
+		int32_t counts = error[i] >> 16;
+		errorSq += (int64_t)counts * counts;
+	}
+	errorSq /= 3;
+
+	// Far more error than expected, the variance has to catch up
+	int64_t expected = (int64_t)MANEUVER_SIGMAS * MANEUVER_SIGMAS
+			* (variance + sampleVar);
+	if (errorSq * FIX16_ONE <= expected || sampleVar > MANEUVER_MAX_VAR) {
+		attitude->numMoving = 0;
+	} else if (++attitude->numMoving >= MANEUVER_SAMPLES) {
+		fix16 matched = MAX_VAR;
+		if (errorSq < 8192)
+			matched = Fix16_fromInt((int)errorSq) - sampleVar;
+		if (matched > variance)
+			variance = matched;
+	}
+	if (variance > MAX_VAR)
+		variance = MAX_VAR;
+
+	fix16 gain = Fix16_div(variance, variance + sampleVar);
+	attitude->variance = Fix16_mul(FIX16_ONE - gain, variance);
+
+	return gain;
+}
+
+// Moves the gyro offset towards what would have turned the estimate onto
+// the sample, trusting shocks as little as the estimate does
+static void updateBias(Attitude *attitude, const int32_t error[3], fix16 sampleVar)
+{
+	int32_t g[3];
+	int64_t lengthSq = 0;
+
+	for (int i = 0; i < 3; i++) {
+		g[i] = attitude->gravity[i] >> 16;
+		lengthSq += (int64_t)g[i] * g[i];
+	}
+	if (lengthSq == 0 || attitude->isTurning) {
+		return;
+	}
+
+	fix16 weight = Fix16_mul(Fix16_mul(BIAS_GAIN, RAD_TO_DEG),
+			Fix16_div(NOISE_VAR, sampleVar));
+
+	// The missing turn is -(g x error) / |g|^2 radians
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+		int64_t cross = (int64_t)g[j] * error[k] - (int64_t)g[k] * error[j];
+
+		attitude->gyroBias[i] += (fix16)((cross * weight / lengthSq) >> 16);
+	}
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Attitude_init(Attitude *attitude, AttitudeMode mode)
+{
+	attitude->mode = mode;
+	attitude->isInit = false;
+	attitude->variance = NOISE_VAR;
+	attitude->numMoving = 0;
+	attitude->gyroUs = 0;
+	attitude->isTurning = false;
+
+	for (int i = 0; i < 3; i++) {
+		attitude->gravity[i] = 0;
+		attitude->gyroBias[i] = 0;
+	}
+}
+
+void Attitude_addAccel(Attitude *attitude, const int16_t accel[3], uint64_t timeUs)
+{
+	int32_t error[3];
+	fix16 gain;
+
+	if (!attitude->isInit) {
+		attitude->isInit = true;
+		for (int i = 0; i < 3; i++) {
+			attitude->gravity[i] = accel[i] * FIX16_ONE;
+		}
+		return;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		error[i] = accel[i] * FIX16_ONE - attitude->gravity[i];
+	}
+
+	fix16 sampleVar = sampleVariance(accel);
+	bool isGyro = hasGyro(attitude, timeUs);
+
+	if (attitude->mode == ATTITUDE_KALMAN) {
+		gain = kalmanGain(attitude, error, sampleVar, isGyro);
+	} else {
+		// Full gain only for a sample as quiet as the noise
+		gain = Fix16_div(Fix16_mul(isGyro ? GAIN_GYRO : GAIN, NOISE_VAR), sampleVar);
+	}
+
+	for (int i = 0; i < 3; i++) {
+		attitude->gravity[i] += Fix16_mul(gain, error[i]);
+	}
+
+	if (isGyro) {
+		updateBias(attitude, error, sampleVar);
+	}
+}
+
+void Attitude_addGyro(Attitude *attitude, const fix16 rate_dps[3], uint64_t timeUs)
+{
+	int64_t dtUs = (int64_t)(timeUs - attitude->gyroUs);
+	int32_t angle[3];
+
+	// Nothing to integrate over for the first sample after a gap
+	if (!hasGyro(attitude, timeUs) || dtUs <= 0) {
+		attitude->gyroUs = timeUs;
+		return;
+	}
+	attitude->gyroUs = timeUs;
+
+	if (!attitude->isInit) {
+		return;
+	}
+
+	// Radians turned since the last sample
+	attitude->isTurning = false;
+	for (int i = 0; i < 3; i++) {
+		int64_t rate = rate_dps[i] - attitude->gyroBias[i];
+		angle[i] = (int32_t)((rate * dtUs * DPS_US_TO_RAD) >> (56 - ANGLE_BITS));
+
+		if (rate > BIAS_MAX_RATE || rate < -BIAS_MAX_RATE)
+			attitude->isTurning = true;
+	}
+
+	// Gravity turns the other way in the body, g += g x angle, with the
+	// second order term so fast turns don't stretch it
+	int32_t turn[3];
+	cross(attitude->gravity, angle, turn);
+
+	int32_t turn2[3];
+	cross(turn, angle, turn2);
+
+	for (int i = 0; i < 3; i++) {
+		attitude->gravity[i] += turn[i] + turn2[i] / 2;
+	}
+}
+
+void Attitude_getGravity(const Attitude *attitude, int32_t gravity[3])
+{
+	for (int i = 0; i < 3; i++) {
+		gravity[i] = attitude->gravity[i] / 256;
+	}
+}
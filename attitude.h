@@ -0,0 +1,64 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - attitude.h														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the attitude
+/	estimator. It tracks the direction of gravity in the accelerometer's
+/	axes from every accelerometer sample, and from a gyro when there is
+/	one, at a fixed cost per sample. Samples that aren't close to 1 g, like
+/	recoil or a knock, are trusted less, so they barely move the estimate.
+/ ----------------------------------------------------------------------------*/
+#ifndef ATTITUDE_H
+#define ATTITUDE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fixmath.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+typedef enum {
+	ATTITUDE_COMPLEMENTARY,		// Fixed time constant
+	ATTITUDE_KALMAN				// Gain from the estimate's variance
+} AttitudeMode;
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	AttitudeMode mode;
+	bool isInit;
+	int32_t gravity[3];			// Estimate in counts, 16 fractional bits
+	fix16 variance;				// Of each component in counts^2, Kalman only
+	int numMoving;				// Samples in a row that disagreed, Kalman only
+	uint64_t gyroUs;			// Time of the last gyro sample, 0 for none
+	fix16 gyroBias[3];			// Estimated gyro offset in degrees/s
+	bool isTurning;				// Too fast to learn the offset
+} Attitude;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// The first accelerometer sample after this sets the estimate
+void Attitude_init(Attitude *attitude, AttitudeMode mode);
+
+// Corrects the estimate with an accelerometer sample in counts (256 per g)
+// Tuned for 400 Hz
+void Attitude_addAccel(Attitude *attitude, const int16_t accel[3], uint64_t timeUs);
+
+// Turns the estimate by a gyro sample, body rates in degrees/s about the
+// accelerometer's axes (right handed)
+// Without a gyro sample for 50 ms the estimate relies on the accelerometer
+void Attitude_addGyro(Attitude *attitude, const fix16 rate_dps[3], uint64_t timeUs);
+
+// Gravity in counts with 8 fractional bits, zero before the first sample
+void Attitude_getGravity(const Attitude *attitude, int32_t gravity[3]);
+
+#endif
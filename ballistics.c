@@ -5,10 +5,49 @@
 /	Bowie Gian
 /	Hong Shi
 /	Created: 2023-06-30
-/	Modified: 2023-11-16
+/	Modified: 2026-10-17
 /
 /	This file contains the functions that calculates ballistic trajectory.
 /
+/	Two paths compute the same pixel offset. The analytic path evaluates
+/	the trajectory in double precision every frame. The table path looks up
+/	values precomputed by Ballistics_setup() for a grid of distance and
+/	elevation, interpolates them bilinearly and applies the cant afterwards.
+/
+/	With P = A*EO and R = (G + HOB)*EO, where A is the bore rise above the
+/	line of sight and G the drop below the bore, and Q = P/cos(elev), the screen
+/	offset (in pixels) is
+/		x = (sin(cant)cos(cant)(P + Q) - sin(cant)R/cos(elev)) / (distance + EO)
+/		z = (cos^2(cant)Q - sin^2(cant)P - cos(cant)R/cos(elev)) / (distance + EO)
+/	P and R are nearly linear in distance and smooth in elevation, so the
+/	table only holds those two and the 1/cos(elev) is applied afterwards.
+/
+/	The fixed path evaluates the analytic model in Q16.16 with CORDIC trig,
+/	the RP2040 has no FPU so it avoids all of the soft float calls. With
+/	the bias angle b, the rise and the distance along the bore reduce to
+/		A = distance*sin(b)/cos(elev + b)
+/		X = distance*cos(elev)/cos(elev + b)
+/	and everything is scaled to pixels at the eye before the cant rotation.
+/
+/	All paths take the time of flight and G at X from the drag solver's
+/	range table (trajectory.c), built by Ballistics_setup() for the load.
+/
+/	Ballistics_solve() keeps the time of flight the path looked up and
+/	fills in the rest of the solution from the offset, so it costs the
+/	path and a table lookup for the speed. The drop and drift are the
+/	offset scaled back from pixels at the eye to metres at the target. A
+/	target crossing at 1 m/s moves time_s metres while the bullet is on its
+/	way, which is the lead. For a target moving along the line of sight the
+/	offset is for the range it will be at when the bullet gets there, with
+/	the time of flight to the measured range looked up along the line of
+/	sight like the table path does, so the path still runs once.
+/
+/	The rifle and optic come from a profile (profile.c). Switching profiles
+/	only reintegrates the trajectory if the load changed, TRAJECTORY_STEPS
+/	RK4 steps per Ballistics_poll() while the old profile stays in use,
+/	then applies it and rebuilds the drop table one distance per poll, so
+/	a frame never stalls.
+/
 /	coordinate system
 /
 /	z yaw	^
@@ -27,15 +66,68 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
+#include "ballistics.h"
+#include "fixmath.h"
+#include "trajectory.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// Drop table grid, outside of it the analytic path is used
+#define TABLE_DIST_STEP_M 5
+#define TABLE_NUM_DIST 37			// 0 - 180 m
+#define TABLE_ELEV_MIN_DEG -60
+#define TABLE_ELEV_STEP_DEG 5
+#define TABLE_NUM_ELEV 25			// -60 - 60 deg
+
+// Fixed path limits, outside of them the analytic path is used
+#define FIXED_MAX_DIST_M 1000
+#define FIXED_MIN_COS (FIX16_ONE / 16)	// About 86 deg of elevation
+
+#define DEFAULT_MODE BALLISTICS_FIXED
+
+// RK4 steps of a new load per Ballistics_poll(), a table is about 1000
+#define TRAJECTORY_STEPS 32
+
+// Largest Q8 offset, a million pixels
+#define Q8_LIMIT (1 << 28)
 
 /*--------------------------------------------------------------*/
 /* Global Variables				 								*/
 /*--------------------------------------------------------------*/
 
-const double gravity = 9.8;
-const double v_muzzle = 390;  // Initial velocity in m/s
-const double elev_bias_rad = 0.012; // angle between muzzle and red dot
-// v_muzzle and elev_bias_rad will need to be tweaked during testing.
+// Derived from the profile once per load, everything the paths read per frame
+typedef struct {
+	double elevBias_rad;
+	double eyeToOptic;
+	double heightOverBore;
+	double pixelsPerMetre;			// 1 / pixelWidth
+	fix16 fixSinBias;
+	fix16 fixBiasDeg;
+	fix16 fixEyeToOptic;
+	fix16 fixHeightOverBore;
+	fix16 fixEyeToOpticPixels;		// eyeToOptic / pixelWidth
+} Constants;
+
+static Constants constants;
+static Profile profile;			// As applied, to tell what a new one changes
+static bool isProfileInit = false;
+static Profile pendingProfile;		// Waiting for its trajectory
+static bool isPending = false;
+
+// Precomputed in pixels, see the top of the file
+typedef struct {
+	float p, r;
+} DropEntry;
+
+static DropEntry dropTable[TABLE_NUM_DIST][TABLE_NUM_ELEV];
+static float sinTable[361];		// sin() of every degree 0 - 360
+static bool isTableInit = false;
+static int rebuildRow = TABLE_NUM_DIST;	// Next dropTable row Ballistics_poll() builds
+
+static BallisticsMode mode = DEFAULT_MODE;
 
 /*--------------------------------------------------------------*/
 /*  Static Function Implemetations								*/
@@ -62,59 +154,27 @@ static struct Vector rotate_vector(double cant_rad, double elev_rad, double r)
 
 }
 
-static double calculateTime(double v0, double target_dist) {
-	// description: calculate the time of flight (eq 184)
-	// input :
-	//			v0 - inital velocity
-	//			target_dist - distance to the target measured by range finder
-	//
-	// output:
-	//			t  - expected time of flight
-
-	double t = target_dist/(v0); // Calculate time of flight
-	return t;
-}
-
-
-
-static double calculateTargetDisplacement(double v0, double g, double t)
-{
-	// description: Calculate the height of the target (e
-	// input: 
-	//			v0 - inital velocity,
-	//			t - time of bullet flight
-	//			g - gravity
-	// output:
-	//			target height - expected bullet drop / expected bullet displacement 
-	//
-
-
-	double target_height = (v0 * t) - (0.5 * g * pow(t, 2));
-
-	return target_height;
-}
-
-
 //  25m   0mm
 //  50m  50mm
 // 100m 250mm
-static struct Vector calculateDrop(double distance_m, double elev_rad, double cant_rad)
+static struct Vector calculateDrop(double distance_m, double elev_rad, double cant_rad,
+		double *time_s)
 {
-
-	struct Vector v0 = rotate_vector(cant_rad, elev_rad + elev_bias_rad, v_muzzle);
+	struct Vector bore = rotate_vector(cant_rad, elev_rad + constants.elevBias_rad, 1);
 	struct Vector aimHeight = rotate_vector(cant_rad, elev_rad, distance_m);
 	struct Vector offset; // calculation results is placed in offset vector
+	double drop;
 
-
-
-	double t = calculateTime(v0.y, aimHeight.y); // when range finder is unlocked distance is range finder reading projected onto y-axis
-	//double t = calculateTime(v0.y, distance_m); // when range finder is locked distance is just range finder reading
+	// Distance along the bore where the bullet passes the target, the drag
+	// solver gives the time of flight and the drop below the bore line there
+	double boreDist = aimHeight.y / bore.y;
+	Trajectory_lookup(boreDist, time_s, &drop);
 
 	offset.y = 0; // theres only a LR bullet displacement and Up Down bullet displacement
 
-	offset.z = calculateTargetDisplacement(v0.z, gravity, t) - aimHeight.z;
+	offset.z = boreDist * bore.z - drop - aimHeight.z;
 
-	offset.x = calculateTargetDisplacement(v0.x, 0, t) - aimHeight.x;
+	offset.x = boreDist * bore.x - aimHeight.x;
 	
 
 	//printf("Drop: %.3f meters, right: %.3f meters\n", offset.z, offset.x);
@@ -144,38 +204,381 @@ static struct Vector proj2screen(double cant_rad, double elevation_rad, double x
 	return result;
 
 }
-/*--------------------------------------------------------------*/
-/*  Function Implemetations										*/
-/*--------------------------------------------------------------*/
-
-void Ballistics_calculatePixelOffset(double distance_m, double elev_deg, double cant_deg, int *xOffset, int *zOffset)
+// Unrounded screen offset in pixels, evaluated in full
+static void analyticOffset(double distance_m, double elev_deg, double cant_deg, double *x, double *z,
+		double *time_s)
 {
-	const double pixelWidth = 0.000254;
-	const double EyeToOptic = .05; 
-	const double HeightOverBore = .06;
-
 	double elev_rad = elev_deg * M_PI / 180.0;  // Launch angle in degrees
 	double cant_rad = cant_deg * M_PI / 180.0;
 
-	struct Vector offset = calculateDrop(distance_m, elev_rad, cant_rad);
+	struct Vector offset = calculateDrop(distance_m, elev_rad, cant_rad, time_s);
 
-	double yTotal = distance_m + EyeToOptic;
-	offset.z = offset.z - HeightOverBore;
+	double yTotal = distance_m + constants.eyeToOptic;
+	offset.z = offset.z - constants.heightOverBore;
 
 	// convert drop distance to offset distance at eye to optic length
-	offset.z = offset.z / yTotal * EyeToOptic;
-	offset.x = offset.x / yTotal * EyeToOptic ;
+	offset.z = offset.z / yTotal * constants.eyeToOptic;
+	offset.x = offset.x / yTotal * constants.eyeToOptic;
 	
 	// project target drop (and LR displacement) onto the screen plane
 	struct Vector screen = proj2screen(cant_rad, elev_rad, offset.x,offset.z);
 
 	// convert m to pixels	
+	*z = screen.z * constants.pixelsPerMetre;
+	*x = screen.x * constants.pixelsPerMetre;
+}
+
+// Pixels to Q8, floored with a compare instead of a libm call
+// Single precision is plenty for 1/256 pixel on the screen, it saturates
+// far off it where only the sign matters
+static int32_t toQ8(float pixels)
+{
+	float scaled = pixels * (1 << BALLISTICS_Q8_SHIFT);
+	int32_t q8;
+
+	// Also catches NaN
+	if (!(scaled < Q8_LIMIT))
+		return Q8_LIMIT;
+	if (!(scaled > -Q8_LIMIT))
+		return -Q8_LIMIT;
+
+	q8 = (int32_t)scaled;
+	return q8 > scaled ? q8 - 1 : q8;
+}
+
+// P and R for one grid point, from the analytic model with no cant
+static DropEntry calculateEntry(double distance_m, double elev_rad)
+{
+	DropEntry entry;
+
+	struct Vector bore = rotate_vector(0, elev_rad + constants.elevBias_rad, 1);
+	struct Vector aim = rotate_vector(0, elev_rad, distance_m);
+	double t, drop;
+
+	double boreDist = aim.y / bore.y;
+	Trajectory_lookup(boreDist, &t, &drop);
+
+	double rise = boreDist * bore.z - aim.z;
+
+	entry.p = (float)(rise * constants.eyeToOptic * constants.pixelsPerMetre);
+	entry.r = (float)((drop + constants.heightOverBore) * constants.eyeToOptic
+			* constants.pixelsPerMetre);
+
+	return entry;
+}
+
+static float lerp(float a, float b, float u)
+{
+	return a + u * (b - a);
+}
+
+// sin and cos of an angle, linearly interpolated from sinTable
+static void tableTrig(float angle_deg, float *sinAngle, float *cosAngle)
+{
+	float deg = fmodf(angle_deg, 360.0f);
+	if (deg < 0)
+		deg += 360.0f;
+	// A tiny negative angle rounds up to 360 when wrapped
+	if (deg >= 360.0f)
+		deg -= 360.0f;
+
+	int i = (int)deg;
+	float u = deg - (float)i;
+	int iCos = (i + 90) % 360;
+
+	*sinAngle = lerp(sinTable[i], sinTable[i + 1], u);
+	*cosAngle = lerp(sinTable[iCos], sinTable[iCos + 1], u);
+}
+
+// Unrounded screen offset in pixels from the drop table
+// The time of flight is taken along the line of sight instead of the bore,
+// which is within a few parts in ten thousand inside the table
+// Returns false if the point is outside of the table
+static bool tableOffset(double distance_m, double elev_deg, double cant_deg, float *x, float *z,
+		double *time_s)
+{
+	float fd = (float)distance_m / TABLE_DIST_STEP_M;
+	float fe = ((float)elev_deg - TABLE_ELEV_MIN_DEG) / TABLE_ELEV_STEP_DEG;
+
+	if (!isTableInit || fd < 0 || fd > TABLE_NUM_DIST - 1 || fe < 0 || fe > TABLE_NUM_ELEV - 1) {
+		return false;
+	}
+
+	int i = (int)fd;
+	int j = (int)fe;
+	if (i > TABLE_NUM_DIST - 2)
+		i = TABLE_NUM_DIST - 2;
+	if (j > TABLE_NUM_ELEV - 2)
+		j = TABLE_NUM_ELEV - 2;
+
+	float u = fd - (float)i;
+	float v = fe - (float)j;
+
+	const DropEntry *e00 = &dropTable[i][j];
+	const DropEntry *e01 = &dropTable[i][j + 1];
+	const DropEntry *e10 = &dropTable[i + 1][j];
+	const DropEntry *e11 = &dropTable[i + 1][j + 1];
+
+	float sinElev, cosElev;
+	tableTrig((float)elev_deg, &sinElev, &cosElev);
 
-	*zOffset = (int)round(screen.z / pixelWidth);
+	float invCosElev = 1.0f / cosElev;
 
-	*xOffset = (int)round(screen.x / pixelWidth);
+	float p = lerp(lerp(e00->p, e01->p, v), lerp(e10->p, e11->p, v), u);
+	float r = lerp(lerp(e00->r, e01->r, v), lerp(e10->r, e11->r, v), u) * invCosElev;
+	float q = p * invCosElev;
+
+	float sinCant, cosCant;
+	tableTrig((float)cant_deg, &sinCant, &cosCant);
+
+	float invDist = 1.0f / ((float)distance_m + (float)constants.eyeToOptic);
+
+	*x = (sinCant * cosCant * (p + q) - sinCant * r) * invDist;
+	*z = (cosCant * cosCant * q - sinCant * sinCant * p - cosCant * r) * invDist;
+
+	double drop;
+	Trajectory_lookup(distance_m, time_s, &drop);
+
+	return true;
+}
+
+// Screen offset in Q16.16 pixels, from the analytic model in fixed point
+// Returns false if the point is outside of the fixed path limits
+static bool fixedOffset(double distance_m, double elev_deg, double cant_deg, fix16 *x, fix16 *z,
+		fix16 *time_s)
+{
+	if (!isProfileInit || distance_m < 0 || distance_m > FIXED_MAX_DIST_M) {
+		return false;
+	}
+
+	fix16 dist = Fix16_fromDouble(distance_m);
+	fix16 elev = Fix16_fromDouble(elev_deg);
+	fix16 cant = Fix16_fromDouble(cant_deg);
+
+	fix16 sinElev, cosElev, sinLaunch, cosLaunch, sinCant, cosCant;
+	Fix16_sinCosDeg(elev, &sinElev, &cosElev);
+	Fix16_sinCosDeg(elev + constants.fixBiasDeg, &sinLaunch, &cosLaunch);
+	Fix16_sinCosDeg(cant, &sinCant, &cosCant);
+
+	if (cosElev < FIXED_MIN_COS || cosLaunch < FIXED_MIN_COS) {
+		return false;
+	}
+
+	// Bore rise above the line of sight and drop below the bore, in m
+	fix16 rise = Fix16_div(Fix16_mul(dist, constants.fixSinBias), cosLaunch);
+	fix16 boreDist = Fix16_div(Fix16_mul(dist, cosElev), cosLaunch);
+	fix16 drop;
+	Trajectory_lookupFixed(boreDist, time_s, &drop);
+
+	// m at the target to pixels at the eye
+	fix16 scale = Fix16_div(constants.fixEyeToOpticPixels, dist + constants.fixEyeToOptic);
+
+	fix16 risePixels = Fix16_mul(rise, scale);
+	fix16 offsetX = Fix16_mul(sinCant, risePixels);
+	fix16 offsetZ = Fix16_mul(cosCant, risePixels)
+			- Fix16_mul(drop + constants.fixHeightOverBore, scale);
+
+	// Project onto the screen plane, same as proj2screen()
+	offsetZ = Fix16_div(offsetZ, cosElev);
+
+	*x = Fix16_mul(offsetX, cosCant) + Fix16_mul(offsetZ, sinCant);
+	*z = Fix16_mul(offsetZ, cosCant) - Fix16_mul(offsetX, sinCant);
+
+	return true;
+}
+
+// Unit conversions, reciprocals and trig of the bias, once per profile
+static void deriveConstants()
+{
+	constants.elevBias_rad = profile.elevBias_rad;
+	constants.eyeToOptic = profile.eyeToOptic_m;
+	constants.heightOverBore = profile.heightOverBore_m;
+	constants.pixelsPerMetre = 1.0 / profile.pixelWidth_m;
+
+	constants.fixSinBias = Fix16_fromDouble(sin(constants.elevBias_rad));
+	constants.fixBiasDeg = Fix16_fromDouble(constants.elevBias_rad * 180.0 / M_PI);
+	constants.fixEyeToOptic = Fix16_fromDouble(constants.eyeToOptic);
+	constants.fixHeightOverBore = Fix16_fromDouble(constants.heightOverBore);
+	constants.fixEyeToOpticPixels = Fix16_fromDouble(constants.eyeToOptic
+			* constants.pixelsPerMetre);
+}
+
+// The offset of the selected path and the time of flight it looked up
+static void solveOffset(double distance_m, double elev_deg, double cant_deg,
+		int32_t *xOffset_q8, int32_t *zOffset_q8, double *time_s)
+{
+	if (mode == BALLISTICS_FIXED) {
+		fix16 x, z, t;
+
+		if (fixedOffset(distance_m, elev_deg, cant_deg, &x, &z, &t)) {
+			*xOffset_q8 = x >> (16 - BALLISTICS_Q8_SHIFT);
+			*zOffset_q8 = z >> (16 - BALLISTICS_Q8_SHIFT);
+			*time_s = Fix16_toDouble(t);
+			return;
+		}
+	} else if (mode == BALLISTICS_TABLE) {
+		float x, z;
+
+		if (tableOffset(distance_m, elev_deg, cant_deg, &x, &z, time_s)) {
+			*xOffset_q8 = toQ8(x);
+			*zOffset_q8 = toQ8(z);
+			return;
+		}
+	}
+
+	double x, z;
+	analyticOffset(distance_m, elev_deg, cant_deg, &x, &z, time_s);
+
+	*xOffset_q8 = toQ8((float)x);
+	*zOffset_q8 = toQ8((float)z);
+}
+
+// Starts using profile, the drop table is rebuilt over the next polls
+static void applyProfile()
+{
+	isProfileInit = true;
+	deriveConstants();
+
+	// Every entry depends on both, the table path falls back until done
+	isTableInit = false;
+	rebuildRow = 0;
+}
+
+// One distance of the drop table, every elevation
+static void buildRow(int i)
+{
+	for (int j = 0; j < TABLE_NUM_ELEV; j++) {
+		double elev_deg = TABLE_ELEV_MIN_DEG + j * TABLE_ELEV_STEP_DEG;
+		dropTable[i][j] = calculateEntry(i * TABLE_DIST_STEP_M, elev_deg * M_PI / 180.0);
+	}
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Ballistics_setup()
+{
+	for (int i = 0; i <= 360; i++) {
+		sinTable[i] = (float)sin(i * M_PI / 180.0);
+	}
+
+	Ballistics_setProfile(Profile_getActive());
+
+	// Nothing to show yet, build the whole table now
+	while (isPending || !isTableInit) {
+		Ballistics_poll();
+	}
+}
+
+void Ballistics_setProfile(const Profile *newProfile)
+{
+	bool isLoadChanged = !isProfileInit
+			|| memcmp(&newProfile->load, &profile.load, sizeof(AmmoLoad)) != 0;
+	bool isOpticChanged = !isProfileInit
+			|| newProfile->elevBias_rad != profile.elevBias_rad
+			|| newProfile->pixelWidth_m != profile.pixelWidth_m
+			|| newProfile->eyeToOptic_m != profile.eyeToOptic_m
+			|| newProfile->heightOverBore_m != profile.heightOverBore_m;
+
+	// Back to the load in use drops a trajectory still being built
+	isPending = false;
+
+	if (isLoadChanged) {
+		pendingProfile = *newProfile;
+		isPending = true;
+		Trajectory_begin(&pendingProfile.load);
+		return;
+	}
+
+	profile = *newProfile;
+	if (isOpticChanged) {
+		applyProfile();
+	}
+}
+
+void Ballistics_poll()
+{
+	if (isPending) {
+		if (Trajectory_continue(TRAJECTORY_STEPS)) {
+			isPending = false;
+			profile = pendingProfile;
+			applyProfile();
+		}
+		return;
+	}
+
+	if (rebuildRow >= TABLE_NUM_DIST) {
+		return;
+	}
+
+	buildRow(rebuildRow);
+	rebuildRow++;
+
+	if (rebuildRow == TABLE_NUM_DIST) {
+		isTableInit = true;
+	}
+}
+
+void Ballistics_setMode(BallisticsMode newMode)
+{
+	mode = newMode;
+}
+
+BallisticsMode Ballistics_getMode()
+{
+	return mode;
+}
+
+void Ballistics_calculateOffset(double distance_m, double elev_deg, double cant_deg,
+		int32_t *xOffset_q8, int32_t *zOffset_q8)
+{
+	double time_s;
+
+	solveOffset(distance_m, elev_deg, cant_deg, xOffset_q8, zOffset_q8, &time_s);
+}
+
+void Ballistics_solve(double distance_m, double radialVelocity_mps, double elev_deg,
+		double cant_deg, BallisticsSolution *solution)
+{
+	double time_s;
+
+	solution->impactDistance_m = distance_m;
+
+	// The time of flight to the measured range is a table lookup, so the
+	// path only runs once, for the range the target will be at
+	if (radialVelocity_mps != 0) {
+		double drop;
+
+		Trajectory_lookup(distance_m, &time_s, &drop);
+		solution->impactDistance_m = distance_m + radialVelocity_mps * time_s;
+		if (solution->impactDistance_m < 0)
+			solution->impactDistance_m = 0;
+	}
+
+	solveOffset(solution->impactDistance_m, elev_deg, cant_deg, &solution->xOffset_q8,
+			&solution->zOffset_q8, &time_s);
+
+	// Pixels at the eye to metres at the target, see analyticOffset()
+	double metresPerQ8 = (solution->impactDistance_m + constants.eyeToOptic)
+			/ (constants.eyeToOptic * constants.pixelsPerMetre * (1 << BALLISTICS_Q8_SHIFT));
+
+	solution->time_s = time_s;
+	// The offset is where the bullet passes the target, up and right
+	solution->drop_m = -solution->zOffset_q8 * metresPerQ8;
+	solution->drift_m = solution->xOffset_q8 * metresPerQ8;
+	solution->velocity_mps = Trajectory_lookupVelocity(solution->impactDistance_m);
+	solution->radialVelocity_mps = radialVelocity_mps;
+	solution->leadPerMps_q8 = toQ8((float)(time_s / metresPerQ8) / (1 << BALLISTICS_Q8_SHIFT));
+}
+
+void Ballistics_calculatePixelOffset(double distance_m, double elev_deg, double cant_deg, int *xOffset, int *zOffset)
+{
+	int32_t x, z;
 
-	return;
+	Ballistics_calculateOffset(distance_m, elev_deg, cant_deg, &x, &z);
+	*xOffset = BALLISTICS_Q8_TO_PIXELS(x);
+	*zOffset = BALLISTICS_Q8_TO_PIXELS(z);
 }
 
 
@@ -5,7 +5,7 @@
 /	Bowie Gian
 /	Hong Shi
 /	Created: 2023-06-30
-/	Modified: 2023-11-17
+/	Modified: 2026-10-17
 /
 /	This file contains the function declarations for the ballistics calculations.
 /
@@ -25,6 +25,51 @@
 #ifndef BALLISTICS_H
 #define BALLISTICS_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "profile.h"
+
+// Offsets in Q8 are 1/256 of a pixel
+#define BALLISTICS_Q8_SHIFT 8
+#define BALLISTICS_Q8_TO_PIXELS(q8) (((q8) + (1 << (BALLISTICS_Q8_SHIFT - 1))) >> BALLISTICS_Q8_SHIFT)
+
+// Everything about one shot, from Ballistics_solve()
+typedef struct {
+	int32_t xOffset_q8;				// Aim point, as Ballistics_calculateOffset
+	int32_t zOffset_q8;
+	double time_s;					// Time of flight
+	double drop_m;					// Bullet below the line of sight at the target, screen vertical
+	double drift_m;					// Bullet right of the line of sight at the target, screen horizontal
+	double velocity_mps;			// Bullet speed left at the target
+	int32_t leadPerMps_q8;			// Lead on the screen per m/s a target crosses at, the
+									// lead at the target is time_s m per m/s
+	double radialVelocity_mps;		// Target moving away, negative closing
+	double impactDistance_m;		// Where the target is when the bullet gets there
+} BallisticsSolution;
+
+typedef enum {
+	BALLISTICS_ANALYTIC,	// Full double precision trajectory every call
+	BALLISTICS_TABLE,		// Interpolated from the table built by Ballistics_setup()
+	BALLISTICS_FIXED		// Q16.16 fixed point and CORDIC trig, no floating point
+} BallisticsMode;
+
+// Applies the active profile and builds every table, call once at boot
+void Ballistics_setup();
+
+// Applies a new profile, only what it changes is recomputed
+// A new load is integrated over the next Ballistics_poll() calls and the
+// old profile is used until then, after that the drop table is rebuilt
+void Ballistics_setProfile(const Profile *profile);
+
+// Call once per frame, rebuilds one distance of the drop table if needed
+void Ballistics_poll();
+
+// Selects how Ballistics_calculatePixelOffset is evaluated
+// The table and fixed paths fall back to the analytic path outside of their
+// grid or limits
+void Ballistics_setMode(BallisticsMode mode);
+BallisticsMode Ballistics_getMode();
+
 // Description: Calculates the bullet drop and returns the offsets as a pixel value to xOffset and zOffset 
 //				screen pixel offset is a positive or negative int with respect to a (0,0) center screen
 // Input :
@@ -50,4 +95,16 @@
 
 void Ballistics_calculatePixelOffset(double distance_m, double elev_deg, double cant_deg, int *xOffset, int *zOffset);
 
+// Same as Ballistics_calculatePixelOffset, but in Q8 (1/256 pixel) and not
+// rounded, for drawing the aim point between pixels
+void Ballistics_calculateOffset(double distance_m, double elev_deg, double cant_deg,
+		int32_t *xOffset_q8, int32_t *zOffset_q8);
+
+// The full solution, computed once per frame and shared with whatever needs it
+// For a radialVelocity_mps other than 0 the aim point itself leads the
+// target to the range it will be at when the bullet arrives, there is no
+// separate marker; leadPerMps_q8 is for the record and isn't drawn
+void Ballistics_solve(double distance_m, double radialVelocity_mps, double elev_deg,
+		double cant_deg, BallisticsSolution *solution);
+
 #endif
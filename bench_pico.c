@@ -0,0 +1,157 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - bench_pico.c													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the on target benchmark firmware. It measures the
+/	CPU cycles per call of every ballistics path, of the angle math and of
+/	a drag solver step, and prints them over USB serial. Build the ifobs_bench target and open
+/	a serial monitor.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "hal.h"
+#include "ballistics.h"
+#include "fixmath.h"
+#include "trajectory.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define DIST_STEP_M 10
+#define DIST_MAX_M 180
+#define ELEV_STEP_DEG 15
+#define ELEV_MAX_DEG 45
+#define CANT_STEP_DEG 30
+#define CANT_MAX_DEG 180
+
+#define NUM_ANGLE_SAMPLES 64
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+// Keeps the compiler from dropping the results
+static volatile double sinkDouble;
+static volatile fix16 sinkFix;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+// Runs one mode over the grid, returns the mean cycles per call and the
+// largest pixel difference against the analytic path
+static uint32_t benchMode(BallisticsMode mode, int *maxError)
+{
+	uint32_t total = 0;
+	int n = 0;
+
+	*maxError = 0;
+
+	for (int d = 0; d <= DIST_MAX_M; d += DIST_STEP_M) {
+		for (int e = -ELEV_MAX_DEG; e <= ELEV_MAX_DEG; e += ELEV_STEP_DEG) {
+			for (int c = -CANT_MAX_DEG; c < CANT_MAX_DEG; c += CANT_STEP_DEG) {
+				int x, z, xRef, zRef;
+
+				Ballistics_setMode(BALLISTICS_ANALYTIC);
+				Ballistics_calculatePixelOffset(d, e, c, &xRef, &zRef);
+
+				Ballistics_setMode(mode);
+				uint32_t start = Hal_cycleCount();
+				Ballistics_calculatePixelOffset(d, e, c, &x, &z);
+				total += (Hal_cycleCount() - start) & HAL_CYCLE_MASK;
+				n++;
+
+				if (abs(x - xRef) > *maxError)
+					*maxError = abs(x - xRef);
+				if (abs(z - zRef) > *maxError)
+					*maxError = abs(z - zRef);
+			}
+		}
+	}
+
+	return total / n;
+}
+
+// The two atan2 calls of the accelerometer angles, double against CORDIC
+static void benchAngle()
+{
+	uint32_t doubleCycles = 0;
+	uint32_t fixedCycles = 0;
+
+	for (int i = 0; i < NUM_ANGLE_SAMPLES; i++) {
+		int16_t x = (int16_t)(i * 8 - 256);
+		int16_t y = (int16_t)(128 - i * 4);
+		int16_t z = -200;
+
+		uint32_t start = Hal_cycleCount();
+		sinkDouble = atan2(y, sqrt((double)x * x + (double)z * z)) * 180 / M_PI
+				+ atan2(x, -z) * 180 / M_PI;
+		doubleCycles += (Hal_cycleCount() - start) & HAL_CYCLE_MASK;
+
+		start = Hal_cycleCount();
+		uint32_t xz = Fix16_isqrt(((uint64_t)(x * x + z * z)) << 16);
+		sinkFix = Fix16_atan2Deg(y * 256, (int32_t)xz) + Fix16_atan2Deg(x, -z);
+		fixedCycles += (Hal_cycleCount() - start) & HAL_CYCLE_MASK;
+	}
+
+	printf("angle     double %6lu cycles  fixed %6lu cycles\n",
+			(unsigned long)(doubleCycles / NUM_ANGLE_SAMPLES),
+			(unsigned long)(fixedCycles / NUM_ANGLE_SAMPLES));
+}
+
+/*--------------------------------------------------------------*/
+/* Main Function												*/
+/*--------------------------------------------------------------*/
+
+int main()
+{
+	static const struct {
+		const char *name;
+		BallisticsMode mode;
+	} modes[] = {
+		{"analytic", BALLISTICS_ANALYTIC},
+		{"table", BALLISTICS_TABLE},
+		{"fixed", BALLISTICS_FIXED},
+	};
+
+	Hal_init();
+	Hal_waitForUsbHost();
+
+	uint32_t start = Hal_cycleCount();
+	Ballistics_setup();
+	printf("Ballistics_setup %lu cycles\n",
+			(unsigned long)((Hal_cycleCount() - start) & HAL_CYCLE_MASK));
+
+	AmmoLoad load = {390, 0.125f, DRAG_G1};
+	start = Hal_cycleCount();
+	int steps = Trajectory_setup(&load);
+	uint32_t cycles = (Hal_cycleCount() - start) & HAL_CYCLE_MASK;
+	printf("Trajectory_setup %d steps, %lu cycles/step\n", steps,
+			(unsigned long)(cycles / steps));
+
+	while (Hal_isRunning()) {
+		for (int i = 0; i < (int)(sizeof(modes) / sizeof(modes[0])); i++) {
+			int maxError;
+			uint32_t cycles = benchMode(modes[i].mode, &maxError);
+
+			printf("%-9s %6lu cycles/call  max error %d px\n",
+					modes[i].name, (unsigned long)cycles, maxError);
+		}
+		benchAngle();
+		printf("\n");
+
+		Hal_sleepMs(2000);
+	}
+
+	return 0;
+}
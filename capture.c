@@ -0,0 +1,143 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - capture.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the sensor capture.
+/
+/	Samples and bytes are packed into one packet at a time, which only
+/	carries the time of the first of them. The accelerometer samples of a
+/	packet are SAMPLE_PERIOD_US apart by the driver's own reckoning, and
+/	the LIDAR bytes of a packet arrived back to back, so a gap of more
+/	than LIDAR_GAP_US starts a new one. Each driver flushes at the end of
+/	its poll, which keeps a packet to one FIFO drain or one frame. A full
+/	packet is handed to the trace queue (trace.c) and sent by its task, a
+/	packet that doesn't fit is lost and shows as a gap in the sequence.
+/	Everything runs on core 0 from the scheduler, so nothing is locked.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include "capture.h"
+#include "trace.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define ACCEL_SAMPLE_SIZE 6
+
+// Two byte times at 115200 baud, a byte is 87 us
+#define LIDAR_GAP_US 200
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static bool isEnabled = false;
+
+static uint8_t packet[CAPTURE_HEADER_SIZE + CAPTURE_MAX_PAYLOAD + 1];
+static CaptureType packetType;
+static int payloadLen = 0;			// 0 when no packet is open
+static uint32_t lastByteUs;
+
+static uint8_t sequence = 0;
+static uint32_t numDropped = 0;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+// Flushes a packet that can't take len more bytes of type, then opens one
+static void reserve(CaptureType type, int len, uint32_t timeUs)
+{
+	if (payloadLen > 0 && (packetType != type || payloadLen + len > CAPTURE_MAX_PAYLOAD)) {
+		Capture_flush();
+	}
+
+	if (payloadLen == 0) {
+		packetType = type;
+		packet[5] = (uint8_t)timeUs;
+		packet[6] = (uint8_t)(timeUs >> 8);
+		packet[7] = (uint8_t)(timeUs >> 16);
+		packet[8] = (uint8_t)(timeUs >> 24);
+	}
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Capture_setEnabled(bool enabled)
+{
+	if (!enabled) {
+		Capture_flush();
+	}
+	isEnabled = enabled;
+}
+
+bool Capture_isEnabled()
+{
+	return isEnabled;
+}
+
+void Capture_accelSample(const uint8_t data[6], uint32_t timeUs)
+{
+	if (!isEnabled) {
+		return;
+	}
+
+	reserve(CAPTURE_ACCEL, ACCEL_SAMPLE_SIZE, timeUs);
+	for (int i = 0; i < ACCEL_SAMPLE_SIZE; i++) {
+		packet[CAPTURE_HEADER_SIZE + payloadLen++] = data[i];
+	}
+}
+
+void Capture_lidarByte(uint8_t byte, uint32_t timeUs)
+{
+	if (!isEnabled) {
+		return;
+	}
+
+	if (payloadLen > 0 && packetType == CAPTURE_LIDAR && timeUs - lastByteUs > LIDAR_GAP_US) {
+		Capture_flush();
+	}
+	reserve(CAPTURE_LIDAR, 1, timeUs);
+	packet[CAPTURE_HEADER_SIZE + payloadLen++] = byte;
+	lastByteUs = timeUs;
+}
+
+void Capture_flush()
+{
+	int len = CAPTURE_HEADER_SIZE + payloadLen;
+	uint8_t sum = 0;
+
+	if (payloadLen == 0) {
+		return;
+	}
+
+	packet[0] = CAPTURE_SYNC0;
+	packet[1] = CAPTURE_SYNC1;
+	packet[2] = (uint8_t)packetType;
+	packet[3] = (uint8_t)payloadLen;
+	packet[4] = sequence++;
+
+	for (int i = 2; i < len; i++) {
+		sum += packet[i];
+	}
+	packet[len] = (uint8_t)-sum;
+
+	if (!Trace_send(packet, (size_t)len + 1)) {
+		numDropped++;
+	}
+	payloadLen = 0;
+}
+
+uint32_t Capture_getDroppedCount()
+{
+	return numDropped;
+}
@@ -0,0 +1,55 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - capture.h														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the sensor capture.
+/	While it is on, every raw accelerometer sample and every byte the
+/	LIDAR sends goes out over USB with the time it arrived, in packets
+/	that share the port with the trace records. The host simulation plays
+/	a capture back through the drivers (IFOBS_SIM_REPLAY in host/sim.h).
+/ ----------------------------------------------------------------------------*/
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// A packet is sync, type, payload length, sequence, time (little endian),
+// the payload and a checksum that makes the bytes after sync add up to 0
+#define CAPTURE_SYNC0 0xA5
+#define CAPTURE_SYNC1 0xFD
+#define CAPTURE_HEADER_SIZE 9
+#define CAPTURE_MAX_PAYLOAD 240
+
+typedef enum {
+	CAPTURE_ACCEL = 1,			// DATAX0 to DATAZ1 per sample, SAMPLE_PERIOD_US apart
+	CAPTURE_LIDAR = 2,			// UART1 bytes back to back from the time
+} CaptureType;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+void Capture_setEnabled(bool enabled);
+bool Capture_isEnabled();
+
+// A raw sample as read from the data registers, and when it was taken
+void Capture_accelSample(const uint8_t data[6], uint32_t timeUs);
+
+// A byte from the LIDAR, and when it arrived
+void Capture_lidarByte(uint8_t byte, uint32_t timeUs);
+
+// Queues the packet being filled, call after each batch
+void Capture_flush();
+
+// Packets lost to a full queue since setup
+uint32_t Capture_getDroppedCount();
+
+#endif
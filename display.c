@@ -0,0 +1,181 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - display.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the core 1 display loop.
+/
+/	Core 1 sleeps until core 0 signals a new solution, draws the newest one
+/	and waits for the flush to reach the screen. The time from the
+/	accelerometer sample to the end of the flush is kept as the latency of
+/	each frame and printed every LATENCY_REPORT_FRAMES frames.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "hal.h"
+#include "display.h"
+#include "oled.h"
+#include "probe.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define LATENCY_REPORT_FRAMES 100
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	uint32_t frames;
+	uint32_t skipped;		// Solutions replaced before they were drawn
+	uint64_t minUs;
+	uint64_t maxUs;
+	uint64_t sumUs;
+} Latency;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static volatile bool isStopping = false;
+static Latency latency;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static void resetLatency()
+{
+	latency.frames = 0;
+	latency.skipped = 0;
+	latency.minUs = UINT64_MAX;
+	latency.maxUs = 0;
+	latency.sumUs = 0;
+}
+
+static void reportLatency()
+{
+	if (latency.frames == 0) {
+		return;
+	}
+
+	printf("latency sample to pixel: min %llu us, mean %llu us, max %llu us, %lu skipped\r\n",
+			(unsigned long long)latency.minUs,
+			(unsigned long long)(latency.sumUs / latency.frames),
+			(unsigned long long)latency.maxUs,
+			(unsigned long)latency.skipped);
+	resetLatency();
+}
+
+static void draw(const Solution *solution)
+{
+	Oled_brightnessPoll();
+
+	PROBE_BEGIN(PROBE_OLED_LOCK);
+	if (solution->isLocked) {
+		Oled_displayLock();
+	} else {
+		Oled_clearLock();
+	}
+	PROBE_END(PROBE_OLED_LOCK);
+
+	PROBE_BEGIN(PROBE_OLED_DISTANCE);
+	Oled_displayDistance(solution->distance_cm);
+	PROBE_END(PROBE_OLED_DISTANCE);
+
+	PROBE_BEGIN(PROBE_OLED_ELEVATION);
+	Oled_displayElevation(solution->elev_deg);
+	PROBE_END(PROBE_OLED_ELEVATION);
+
+	PROBE_BEGIN(PROBE_OLED_CANT);
+	Oled_displayCant(solution->cant_deg);
+	PROBE_END(PROBE_OLED_CANT);
+
+	PROBE_BEGIN(PROBE_OLED_DOT);
+	int statusOled = Oled_displayReticle(solution->ballistics.xOffset_q8,
+			solution->ballistics.zOffset_q8);
+
+	if (statusOled == OLED_OFF_SCREEN) {
+		Oled_displayCalcDotErr();
+	} else if (statusOled == OLED_SUCCESS) {
+		Oled_clearCalcDotErr();
+	}
+	PROBE_END(PROBE_OLED_DOT);
+
+	// Starts the DMA, the wait for it isn't CPU time
+	PROBE_BEGIN(PROBE_OLED_FLUSH);
+	Oled_flush();
+	PROBE_END(PROBE_OLED_FLUSH);
+	Oled_waitFlush();
+}
+
+static void displayMain()
+{
+	uint32_t lastSequence = 0;
+
+	Oled_setup();
+	Oled_displayCenter();
+	resetLatency();
+
+	while (true) {
+		Solution solution;
+		uint32_t sequence = Solution_read(&solution);
+
+		if (sequence != lastSequence) {
+			if (lastSequence != 0) {
+				latency.skipped += sequence - lastSequence - 1;
+			}
+			lastSequence = sequence;
+
+			draw(&solution);
+
+			uint64_t us = Hal_timeUs() - solution.sampleUs;
+			if (us < latency.minUs)
+				latency.minUs = us;
+			if (us > latency.maxUs)
+				latency.maxUs = us;
+			latency.sumUs += us;
+
+			if (++latency.frames >= LATENCY_REPORT_FRAMES) {
+				reportLatency();
+			}
+		} else if (isStopping) {
+			break;
+		} else {
+			Hal_coreWait();
+		}
+	}
+
+	reportLatency();
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Display_start()
+{
+	isStopping = false;
+	Hal_launchCore1(displayMain);
+}
+
+void Display_publish(const Solution *solution)
+{
+	Solution_publish(solution);
+	Hal_coreSignal();
+}
+
+void Display_stop()
+{
+	isStopping = true;
+	Hal_coreSignal();
+	Hal_joinCore1();
+}
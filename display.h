@@ -0,0 +1,33 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - display.h														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the display pipeline.
+/	Core 1 owns the OLED and redraws it from each published solution while
+/	core 0 keeps reading the sensors and solving the ballistics.
+/ ----------------------------------------------------------------------------*/
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "solution.h"
+
+#define DISPLAY_PERIOD_US 33333		// 30 Hz, one pass of the main loop
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Launches core 1, which sets up the OLED and waits for solutions
+void Display_start();
+
+// Hands a solution to core 1, returns straight away
+// Solutions published faster than the screen updates are skipped
+void Display_publish(const Solution *solution);
+
+// Lets core 1 finish the frame in progress and waits for it to return
+void Display_stop();
+
+#endif
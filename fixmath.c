@@ -0,0 +1,238 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - fixmath.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the Q16.16 fixed point math functions.
+/
+/	CORDIC keeps x and y in 2.30 and angles in 3.29 radians, which leaves
+/	enough headroom for the 1.647 gain of the vectoring mode and for +-pi.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdbool.h>
+#include "fixmath.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define CORDIC_ITERATIONS 24
+
+#define CORDIC_GAIN_INV 652032874		// 1/1.646760258 in 2.30
+#define PI_3_29 1686629713				// pi in 3.29
+
+#define DEG_90 (90 * FIX16_ONE)
+#define DEG_180 (180 * FIX16_ONE)
+#define DEG_360 (360 * FIX16_ONE)
+
+// pi/180 * 2^37 converts 16.16 degrees to 3.29 radians after >> 24
+#define DEG_TO_RAD_3_29 2398762259LL
+// 180/pi * 2^19 converts 3.29 radians to 16.16 degrees after >> 32
+#define RAD_3_29_TO_DEG 30039490LL
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+// atan(2^-i) in 3.29 radians
+static const int32_t cordicAtan[CORDIC_ITERATIONS] = {
+	421657428, 248918915, 131521918, 66762579, 33510843, 16771758,
+	8387925, 4194219, 2097141, 1048575, 524288, 262144,
+	131072, 65536, 32768, 16384, 8192, 4096,
+	2048, 1024, 512, 256, 128, 64
+};
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static fix16 saturate(int64_t value)
+{
+	if (value > FIX16_MAX)
+		return FIX16_MAX;
+	if (value < FIX16_MIN)
+		return FIX16_MIN;
+	return (fix16)value;
+}
+
+// 2.30 to 16.16, rounded
+static fix16 from2_30(int32_t value)
+{
+	return (fix16)((value + (1 << 13)) >> 14);
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+fix16 Fix16_fromDouble(double value)
+{
+	return saturate(llround(value * FIX16_ONE));
+}
+
+double Fix16_toDouble(fix16 value)
+{
+	return (double)value / FIX16_ONE;
+}
+
+fix16 Fix16_div(fix16 a, fix16 b)
+{
+	if (b == 0) {
+		return a >= 0 ? FIX16_MAX : FIX16_MIN;
+	}
+
+	int64_t num = (int64_t)a * FIX16_ONE;
+
+	// Round to nearest
+	if ((num >= 0) == (b >= 0)) {
+		num += (b >= 0 ? b : -(int64_t)b) / 2;
+	} else {
+		num -= (b >= 0 ? b : -(int64_t)b) / 2;
+	}
+
+	return saturate(num / b);
+}
+
+int Fix16_round(fix16 value)
+{
+	if (value >= 0) {
+		return (int)(((int64_t)value + (1 << 15)) >> 16);
+	}
+	return -(int)((-(int64_t)value + (1 << 15)) >> 16);
+}
+
+uint32_t Fix16_isqrt(uint64_t value)
+{
+	uint64_t result = 0;
+	uint64_t bit = 1ULL << 62;
+
+	while (bit > value) {
+		bit >>= 2;
+	}
+
+	while (bit != 0) {
+		if (value >= result + bit) {
+			value -= result + bit;
+			result = (result >> 1) + bit;
+		} else {
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (uint32_t)result;
+}
+
+fix16 Fix16_sqrt(fix16 value)
+{
+	if (value <= 0) {
+		return 0;
+	}
+	return (fix16)Fix16_isqrt((uint64_t)value << 16);
+}
+
+void Fix16_sinCosDeg(fix16 angle_deg, fix16 *sinAngle, fix16 *cosAngle)
+{
+	int32_t deg = angle_deg % DEG_360;
+	bool isCosFlipped = false;
+
+	// Reduce to [-90, 90], cos changes sign in the other two quadrants
+	if (deg > DEG_180)
+		deg -= DEG_360;
+	else if (deg <= -DEG_180)
+		deg += DEG_360;
+
+	if (deg > DEG_90) {
+		deg = DEG_180 - deg;
+		isCosFlipped = true;
+	} else if (deg < -DEG_90) {
+		deg = -DEG_180 - deg;
+		isCosFlipped = true;
+	}
+
+	// Rotation mode, starting on the x axis pre-scaled by the gain
+	int32_t x = CORDIC_GAIN_INV;
+	int32_t y = 0;
+	int32_t z = (int32_t)(((int64_t)deg * DEG_TO_RAD_3_29) >> 24);
+
+	for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+		int32_t dx = y >> i;
+		int32_t dy = x >> i;
+
+		if (z >= 0) {
+			x -= dx;
+			y += dy;
+			z -= cordicAtan[i];
+		} else {
+			x += dx;
+			y -= dy;
+			z += cordicAtan[i];
+		}
+	}
+
+	*sinAngle = from2_30(y);
+	*cosAngle = isCosFlipped ? -from2_30(x) : from2_30(x);
+}
+
+fix16 Fix16_atan2Deg(int32_t y, int32_t x)
+{
+	int64_t x64 = x;
+	int64_t y64 = y;
+	int32_t z = 0;
+
+	if (x == 0 && y == 0) {
+		return 0;
+	}
+
+	// Rotate into the right half plane
+	if (x64 < 0) {
+		x64 = -x64;
+		y64 = -y64;
+		z = y >= 0 ? PI_3_29 : -PI_3_29;
+	}
+
+	// Scale so the larger input is in [2^27, 2^28), the gain stays in 2.30
+	int64_t larger = x64 > (y64 >= 0 ? y64 : -y64) ? x64 : (y64 >= 0 ? y64 : -y64);
+	while (larger >= (1LL << 28)) {
+		larger >>= 1;
+		x64 >>= 1;
+		y64 >>= 1;
+	}
+	while (larger < (1LL << 27)) {
+		larger <<= 1;
+		x64 <<= 1;
+		y64 <<= 1;
+	}
+
+	// Vectoring mode, drive y to 0 and accumulate the angle
+	int32_t xi = (int32_t)x64;
+	int32_t yi = (int32_t)y64;
+
+	for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+		int32_t dx = yi >> i;
+		int32_t dy = xi >> i;
+
+		if (yi > 0) {
+			xi += dx;
+			yi -= dy;
+			z += cordicAtan[i];
+		} else {
+			xi -= dx;
+			yi += dy;
+			z -= cordicAtan[i];
+		}
+	}
+
+	// Keep the result in (-180, 180]
+	if (z <= -PI_3_29)
+		z = PI_3_29;
+
+	return (fix16)(((int64_t)z * RAD_3_29_TO_DEG + (1LL << 31)) >> 32);
+}
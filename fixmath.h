@@ -0,0 +1,66 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - fixmath.h														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for Q16.16 fixed point
+/	math. The Cortex-M0+ has no FPU, so every double operation is a library
+/	call costing hundreds of cycles, while these are integer only.
+/	Trig is CORDIC with 2.30 internal precision and works in degrees, since
+/	that is what the sensors and the display use.
+/ ----------------------------------------------------------------------------*/
+#ifndef FIXMATH_H
+#define FIXMATH_H
+
+#include <stdint.h>
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+typedef int32_t fix16;
+
+#define FIX16_ONE (1 << 16)
+#define FIX16_MAX INT32_MAX
+#define FIX16_MIN INT32_MIN
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+static inline fix16 Fix16_fromInt(int value)
+{
+	return (fix16)(value * FIX16_ONE);
+}
+
+// Rounded to nearest
+static inline fix16 Fix16_mul(fix16 a, fix16 b)
+{
+	return (fix16)(((int64_t)a * b + (1 << 15)) >> 16);
+}
+
+// Conversions to and from double, keep these off the hot path
+fix16 Fix16_fromDouble(double value);
+double Fix16_toDouble(fix16 value);
+
+// Saturates on overflow and division by zero
+fix16 Fix16_div(fix16 a, fix16 b);
+
+// Rounds half away from zero, like round()
+int Fix16_round(fix16 value);
+
+// Integer square root, floor(sqrt(value))
+uint32_t Fix16_isqrt(uint64_t value);
+
+// Negative values return 0
+fix16 Fix16_sqrt(fix16 value);
+
+// sin and cos of an angle in degrees, any range
+void Fix16_sinCosDeg(fix16 angle_deg, fix16 *sinAngle, fix16 *cosAngle);
+
+// atan2(y, x) in degrees (-180, 180], y and x can be in any common scale
+fix16 Fix16_atan2Deg(int32_t y, int32_t x);
+
+#endif
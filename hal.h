@@ -0,0 +1,147 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - hal.h															   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the hardware
+/	abstraction layer. The drivers only talk to the hardware through these,
+/	hal_pico.c implements them with the pico SDK and host/hal_host.c
+/	implements them against simulated peripherals.
+/ ----------------------------------------------------------------------------*/
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// Values for Hal_gpioSetDir
+#define HAL_GPIO_IN false
+#define HAL_GPIO_OUT true
+
+typedef enum {
+	HAL_SPI0,
+	HAL_SPI1
+} HalSpi;
+
+typedef enum {
+	HAL_UART0,
+	HAL_UART1
+} HalUart;
+
+typedef enum {
+	HAL_GPIO_FUNC_SPI,
+	HAL_GPIO_FUNC_UART
+} HalGpioFunc;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Initializes stdio (and the simulation on the host), safe to call twice
+void Hal_init();
+
+// Blocks until a serial monitor is attached to the USB port
+void Hal_waitForUsbHost();
+
+// Called once per main loop iteration
+// Always true on the RP2040, the host stops after the requested frame count
+bool Hal_isRunning();
+
+// GPIO
+void Hal_gpioInit(uint32_t pin);
+void Hal_gpioSetDir(uint32_t pin, bool out);
+void Hal_gpioPut(uint32_t pin, bool value);
+bool Hal_gpioGet(uint32_t pin);
+void Hal_gpioPullUp(uint32_t pin);
+void Hal_gpioSetFunction(uint32_t pin, HalGpioFunc func);
+
+// Calls handler from the GPIO interrupt on each rising edge of pin, the
+// interrupt is taken on the calling core
+void Hal_gpioSetRiseIrq(uint32_t pin, void (*handler)(void));
+
+// SPI, always MSB first
+void Hal_spiInit(HalSpi spi, uint32_t baudrate);
+void Hal_spiSetFormat(HalSpi spi, uint32_t bits, uint32_t cpol, uint32_t cpha);
+int Hal_spiWrite(HalSpi spi, const uint8_t *src, size_t len);
+int Hal_spiRead(HalSpi spi, uint8_t repeatedTx, uint8_t *dst, size_t len);
+
+// Starts a DMA transfer of len bytes to the SPI, paced by its TX DREQ
+// src must stay valid until done is called from the DMA interrupt, which
+// happens after the last bit has left the SPI. done may be NULL.
+// The DMA interrupt is taken on the core that first used the port.
+void Hal_spiWriteDma(HalSpi spi, const uint8_t *src, size_t len, void (*done)(void));
+
+// Same as Hal_spiWriteDma, and the len bytes received are stored in dst
+// done is called once the last byte has been received
+void Hal_spiTransferDma(HalSpi spi, const uint8_t *src, uint8_t *dst, size_t len,
+		void (*done)(void));
+bool Hal_spiDmaBusy(HalSpi spi);
+void Hal_spiDmaWait(HalSpi spi);
+
+// UART
+void Hal_uartInit(HalUart uart, uint32_t baudrate);
+bool Hal_uartIsEnabled(HalUart uart);
+bool Hal_uartIsReadable(HalUart uart);
+uint8_t Hal_uartGetc(HalUart uart);
+
+// Blocks only while the TX FIFO is full, 32 bytes go straight in
+void Hal_uartWrite(HalUart uart, const uint8_t *src, size_t len);
+
+// Calls handler from the RX interrupt whenever the UART has data
+void Hal_uartSetRxIrq(HalUart uart, void (*handler)(void));
+
+// Time
+uint64_t Hal_timeUs();
+void Hal_sleepMs(uint32_t ms);
+
+// Sleeps until the absolute time us (Hal_timeUs()), returns at once if it
+// has passed. On the RP2040 any interrupt also ends the sleep early.
+void Hal_sleepUntilUs(uint64_t us);
+
+// Settings flash, one reserved sector at the end of flash
+#define HAL_FLASH_SECTOR_SIZE 4096
+
+// Memory mapped contents of the settings sector, erased bytes read 0xFF
+const uint8_t *Hal_flashSector();
+
+// Erases the settings sector and programs len bytes from data
+// Blocks for tens of ms with interrupts off, never call it per frame
+void Hal_flashWriteSector(const uint8_t *data, size_t len);
+
+// USB serial input, returns -1 when nothing is waiting, never blocks
+int Hal_serialGetc();
+
+// USB serial output, takes as much of src as fits in the TX buffer
+// Returns the number of bytes taken, never blocks
+size_t Hal_serialWrite(const uint8_t *src, size_t len);
+
+// Second core
+// Core 1 runs entry, on the host it is a thread in the same virtual time
+void Hal_launchCore1(void (*entry)(void));
+
+// Waits for the core 1 entry function to return, never on the RP2040
+void Hal_joinCore1();
+
+// Wakes the other core from Hal_coreWait()
+void Hal_coreSignal();
+
+// Sleeps until the other core calls Hal_coreSignal(), can return early
+void Hal_coreWait();
+
+// Free running counter for profiling, CPU cycles on the RP2040 (SysTick)
+// and host nanoseconds on the host. Only HAL_CYCLE_MASK bits are valid,
+// take differences as (end - start) & HAL_CYCLE_MASK.
+#define HAL_CYCLE_MASK 0x00FFFFFF
+uint32_t Hal_cycleCount();
+
+// Hal_cycleCount() ticks per microsecond
+uint32_t Hal_cyclesPerUs();
+
+#endif
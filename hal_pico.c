@@ -0,0 +1,471 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - hal_pico.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the RP2040 implementation of the hardware abstraction
+/	layer. Every function is a thin wrapper around the pico SDK.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/multicore.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "tusb.h"
+#include "hal.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// Last sector of flash, the program image must stay below it
+#define FLASH_SETTINGS_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+// DMA channels per SPI port, claimed on first use
+static int dmaChannel[2] = {-1, -1};
+static int dmaRxChannel[2] = {-1, -1};
+static int dmaIrqIndex[2];				// DMA_IRQ_0 + the claiming core
+static volatile bool isDmaActive[2] = {false, false};
+static volatile bool isDmaRx[2] = {false, false};
+static void (*dmaDone[2])(void);
+static bool isDmaIrqInit[2] = {false, false};
+
+static void (*gpioIrq[NUM_BANK0_GPIOS])(void);
+
+// Programming is done in whole pages, padded with 0xFF
+static uint8_t flashBuffer[FLASH_SECTOR_SIZE];
+
+static void (*core1Entry)(void);
+static volatile bool isCore1Running = false;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static spi_inst_t *getSpi(HalSpi spi)
+{
+	return spi == HAL_SPI0 ? spi0 : spi1;
+}
+
+static uart_inst_t *getUart(HalUart uart)
+{
+	return uart == HAL_UART0 ? uart0 : uart1;
+}
+
+static void dmaIrq(int irqIndex)
+{
+	for (int i = 0; i < 2; i++) {
+		int channel = dmaChannel[i];
+		int rxChannel = dmaRxChannel[i];
+		spi_inst_t *spi = getSpi(i);
+
+		if (channel < 0 || dmaIrqIndex[i] != irqIndex) {
+			continue;
+		}
+
+		bool isTxDone = dma_irqn_get_channel_status(irqIndex, channel);
+		bool isRxDone = rxChannel >= 0 && dma_irqn_get_channel_status(irqIndex, rxChannel);
+		if (isTxDone)
+			dma_irqn_acknowledge_channel(irqIndex, channel);
+		if (isRxDone)
+			dma_irqn_acknowledge_channel(irqIndex, rxChannel);
+
+		// A transfer is done once the last byte is received
+		if (isDmaRx[i] ? !isRxDone : !isTxDone) {
+			continue;
+		}
+
+		if (!isDmaRx[i]) {
+			// The channel is done when the last byte enters the TX FIFO,
+			// wait for it to be shifted out before the caller releases CS
+			while (spi_is_busy(spi)) {
+				tight_loop_contents();
+			}
+
+			// Transmit only, drain RX and clear the overrun it caused
+			while (spi_is_readable(spi)) {
+				(void)spi_get_hw(spi)->dr;
+			}
+			spi_get_hw(spi)->icr = SPI_SSPICR_RORIC_BITS;
+		}
+
+		isDmaActive[i] = false;
+		if (dmaDone[i]) {
+			dmaDone[i]();
+		}
+	}
+}
+
+static void dmaIrq0Handler()
+{
+	dmaIrq(0);
+}
+
+static void dmaIrq1Handler()
+{
+	dmaIrq(1);
+}
+
+static void gpioIrqHandler(uint gpio, uint32_t events)
+{
+	(void)events;
+
+	if (gpioIrq[gpio]) {
+		gpioIrq[gpio]();
+	}
+}
+
+static void core1Main()
+{
+	// Lets core 0 pause this core while it writes the flash
+	multicore_lockout_victim_init();
+
+	core1Entry();
+
+	isCore1Running = false;
+	__sev();
+}
+
+// Each core has its own DMA interrupt line, the handler is installed on
+// the core that first uses the port
+static int claimDma(HalSpi spi)
+{
+	if (dmaChannel[spi] >= 0) {
+		return dmaChannel[spi];
+	}
+
+	int irqIndex = get_core_num();
+
+	dmaChannel[spi] = dma_claim_unused_channel(true);
+	dmaIrqIndex[spi] = irqIndex;
+	dma_irqn_set_channel_enabled(irqIndex, dmaChannel[spi], true);
+
+	if (!isDmaIrqInit[irqIndex]) {
+		isDmaIrqInit[irqIndex] = true;
+		irq_add_shared_handler(DMA_IRQ_0 + irqIndex,
+				irqIndex == 0 ? dmaIrq0Handler : dmaIrq1Handler,
+				PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+		irq_set_enabled(DMA_IRQ_0 + irqIndex, true);
+	}
+
+	return dmaChannel[spi];
+}
+
+static int claimDmaRx(HalSpi spi)
+{
+	claimDma(spi);
+
+	if (dmaRxChannel[spi] < 0) {
+		dmaRxChannel[spi] = dma_claim_unused_channel(true);
+		dma_irqn_set_channel_enabled(dmaIrqIndex[spi], dmaRxChannel[spi], true);
+	}
+
+	return dmaRxChannel[spi];
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Hal_init()
+{
+	stdio_init_all();
+}
+
+void Hal_waitForUsbHost()
+{
+	cdcd_init();
+	printf("waiting for usb host");
+	while (!tud_cdc_connected()) {
+		printf(".");
+		sleep_ms(500);
+	}
+	printf("\nusb host detected!\n");
+}
+
+bool Hal_isRunning()
+{
+	return true;
+}
+
+void Hal_gpioInit(uint32_t pin)
+{
+	gpio_init(pin);
+}
+
+void Hal_gpioSetDir(uint32_t pin, bool out)
+{
+	gpio_set_dir(pin, out);
+}
+
+void Hal_gpioPut(uint32_t pin, bool value)
+{
+	gpio_put(pin, value);
+}
+
+bool Hal_gpioGet(uint32_t pin)
+{
+	return gpio_get(pin);
+}
+
+void Hal_gpioPullUp(uint32_t pin)
+{
+	gpio_pull_up(pin);
+}
+
+void Hal_gpioSetFunction(uint32_t pin, HalGpioFunc func)
+{
+	gpio_set_function(pin, func == HAL_GPIO_FUNC_SPI ? GPIO_FUNC_SPI : GPIO_FUNC_UART);
+}
+
+void Hal_gpioSetRiseIrq(uint32_t pin, void (*handler)(void))
+{
+	gpioIrq[pin] = handler;
+	gpio_set_irq_enabled_with_callback(pin, GPIO_IRQ_EDGE_RISE, true, gpioIrqHandler);
+}
+
+void Hal_spiInit(HalSpi spi, uint32_t baudrate)
+{
+	spi_init(getSpi(spi), baudrate);
+}
+
+void Hal_spiSetFormat(HalSpi spi, uint32_t bits, uint32_t cpol, uint32_t cpha)
+{
+	spi_set_format(getSpi(spi), bits, cpol, cpha, SPI_MSB_FIRST);
+}
+
+int Hal_spiWrite(HalSpi spi, const uint8_t *src, size_t len)
+{
+	return spi_write_blocking(getSpi(spi), src, len);
+}
+
+int Hal_spiRead(HalSpi spi, uint8_t repeatedTx, uint8_t *dst, size_t len)
+{
+	return spi_read_blocking(getSpi(spi), repeatedTx, dst, len);
+}
+
+void Hal_spiWriteDma(HalSpi spi, const uint8_t *src, size_t len, void (*done)(void))
+{
+	int channel = claimDma(spi);
+	dma_channel_config config = dma_channel_get_default_config(channel);
+
+	channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+	channel_config_set_read_increment(&config, true);
+	channel_config_set_write_increment(&config, false);
+	channel_config_set_dreq(&config, spi_get_dreq(getSpi(spi), true));
+
+	dmaDone[spi] = done;
+	isDmaRx[spi] = false;
+	isDmaActive[spi] = true;
+	dma_channel_configure(channel, &config, &spi_get_hw(getSpi(spi))->dr,
+			src, len, true);
+}
+
+void Hal_spiTransferDma(HalSpi spi, const uint8_t *src, uint8_t *dst, size_t len,
+		void (*done)(void))
+{
+	int channel = claimDma(spi);
+	int rxChannel = claimDmaRx(spi);
+	spi_inst_t *inst = getSpi(spi);
+	dma_channel_config config = dma_channel_get_default_config(channel);
+	dma_channel_config rxConfig = dma_channel_get_default_config(rxChannel);
+
+	channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+	channel_config_set_read_increment(&config, true);
+	channel_config_set_write_increment(&config, false);
+	channel_config_set_dreq(&config, spi_get_dreq(inst, true));
+
+	channel_config_set_transfer_data_size(&rxConfig, DMA_SIZE_8);
+	channel_config_set_read_increment(&rxConfig, false);
+	channel_config_set_write_increment(&rxConfig, true);
+	channel_config_set_dreq(&rxConfig, spi_get_dreq(inst, false));
+
+	dmaDone[spi] = done;
+	isDmaRx[spi] = true;
+	isDmaActive[spi] = true;
+	dma_channel_configure(rxChannel, &rxConfig, dst, &spi_get_hw(inst)->dr, len, false);
+	dma_channel_configure(channel, &config, &spi_get_hw(inst)->dr, src, len, false);
+
+	// Together, so RX is ready for the first byte
+	dma_start_channel_mask((1u << channel) | (1u << rxChannel));
+}
+
+bool Hal_spiDmaBusy(HalSpi spi)
+{
+	return isDmaActive[spi];
+}
+
+void Hal_spiDmaWait(HalSpi spi)
+{
+	while (isDmaActive[spi]) {
+		tight_loop_contents();
+	}
+}
+
+void Hal_uartInit(HalUart uart, uint32_t baudrate)
+{
+	uart_init(getUart(uart), baudrate);
+}
+
+bool Hal_uartIsEnabled(HalUart uart)
+{
+	return uart_is_enabled(getUart(uart));
+}
+
+bool Hal_uartIsReadable(HalUart uart)
+{
+	return uart_is_readable(getUart(uart));
+}
+
+uint8_t Hal_uartGetc(HalUart uart)
+{
+	return (uint8_t)uart_getc(getUart(uart));
+}
+
+void Hal_uartWrite(HalUart uart, const uint8_t *src, size_t len)
+{
+	uart_write_blocking(getUart(uart), src, len);
+}
+
+void Hal_uartSetRxIrq(HalUart uart, void (*handler)(void))
+{
+	int irq = uart == HAL_UART0 ? UART0_IRQ : UART1_IRQ;
+
+	irq_set_exclusive_handler(irq, handler);
+	irq_set_enabled(irq, true);
+
+	// RX FIFO level and RX timeout interrupts
+	uart_set_irq_enables(getUart(uart), true, false);
+}
+
+uint64_t Hal_timeUs()
+{
+	return time_us_64();
+}
+
+void Hal_sleepMs(uint32_t ms)
+{
+	sleep_ms(ms);
+}
+
+void Hal_sleepUntilUs(uint64_t us)
+{
+	// One WFE, the caller re-checks whatever the interrupt released
+	best_effort_wfe_or_timeout(from_us_since_boot(us));
+}
+
+const uint8_t *Hal_flashSector()
+{
+	return (const uint8_t *)(XIP_BASE + FLASH_SETTINGS_OFFSET);
+}
+
+void Hal_flashWriteSector(const uint8_t *data, size_t len)
+{
+	if (len > FLASH_SECTOR_SIZE) {
+		len = FLASH_SECTOR_SIZE;
+	}
+	size_t programLen = (len + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE;
+
+	memset(flashBuffer, 0xFF, programLen);
+	memcpy(flashBuffer, data, len);
+
+	// XIP is unavailable while the flash is busy, nothing may run from it,
+	// including the other core
+	bool isLockout = isCore1Running;
+	if (isLockout) {
+		multicore_lockout_start_blocking();
+	}
+
+	uint32_t interrupts = save_and_disable_interrupts();
+	flash_range_erase(FLASH_SETTINGS_OFFSET, FLASH_SECTOR_SIZE);
+	flash_range_program(FLASH_SETTINGS_OFFSET, flashBuffer, programLen);
+	restore_interrupts(interrupts);
+
+	if (isLockout) {
+		multicore_lockout_end_blocking();
+	}
+}
+
+int Hal_serialGetc()
+{
+	int c = getchar_timeout_us(0);
+	return c == PICO_ERROR_TIMEOUT ? -1 : c;
+}
+
+// Goes through stdio so it doesn't interleave with a printf mid string
+size_t Hal_serialWrite(const uint8_t *src, size_t len)
+{
+	// Dropped like stdio drops text when nobody is listening
+	if (!tud_cdc_connected()) {
+		return len;
+	}
+
+	size_t space = tud_cdc_write_available();
+	if (len > space)
+		len = space;
+	if (len > 0) {
+		stdio_put_string((const char *)src, (int)len, false, false);
+	}
+	return len;
+}
+
+void Hal_launchCore1(void (*entry)(void))
+{
+	core1Entry = entry;
+	isCore1Running = true;
+	multicore_launch_core1(core1Main);
+}
+
+void Hal_joinCore1()
+{
+	while (isCore1Running) {
+		__wfe();
+	}
+}
+
+void Hal_coreSignal()
+{
+	__sev();
+}
+
+void Hal_coreWait()
+{
+	__wfe();
+}
+
+uint32_t Hal_cycleCount()
+{
+	// SysTick on the processor clock, started on first use
+	if (!(systick_hw->csr & 1)) {
+		systick_hw->rvr = HAL_CYCLE_MASK;
+		systick_hw->cvr = 0;
+		systick_hw->csr = 0x5;
+	}
+
+	// Counts down
+	return HAL_CYCLE_MASK - systick_hw->cvr;
+}
+
+uint32_t Hal_cyclesPerUs()
+{
+	return clock_get_hz(clk_sys) / 1000000;
+}
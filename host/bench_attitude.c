@@ -0,0 +1,434 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - bench_attitude.c												   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains a replay harness for the attitude filters. It feeds
+/	an accelerometer log, with or without gyro samples, through the window
+/	average and the attitude estimator and reports for each one how long it
+/	takes to settle after the rifle comes to rest, the noise once settled,
+/	the largest error once settled (recoil and knocks) and the host time
+/	per sample.
+/
+/	A log has one sample per line:
+/		a,<us>,<x>,<y>,<z>		accelerometer counts (256 per g)
+/		g,<us>,<x>,<y>,<z>		gyro rates in degrees/s
+/		t,<us>,<elev>,<cant>	the rifle is held still at this attitude
+/								from here on, in degrees
+/		m,<us>					the rifle starts moving, the samples up
+/								to the next t line aren't scored
+/	Lines starting with # are skipped. Settling needs t lines, without them
+/	only the mean angles of the whole log are printed.
+/
+/	Without a log a synthetic one is used: a still rifle, a quick move, a
+/	recoil shock and a move to a cant near 180 degrees, with noise and a
+/	biased gyro. "-w file" writes it out to show the format.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "attitude.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define MAX_EVENTS 200000
+#define SETTLED_DEG 0.1
+#define SETTLED_SAMPLES 20			// In a row, 50 ms at 400 Hz
+#define AVERAGING_SIZE 16
+
+// Synthetic log
+#define SAMPLE_US 2500
+#define LOG_US 8000000
+#define LSB_PER_G 256
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	char type;				// 'a', 'g' or 't'
+	uint64_t timeUs;
+	double value[3];
+} Event;
+
+typedef struct {
+	const char *name;
+	int filter;				// -1 for the window average, else an AttitudeMode
+	int isGyro;
+} Filter;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static Event events[MAX_EVENTS];
+static int numEvents = 0;
+
+static const Filter filters[] = {
+	{"average 16", -1, 0},
+	{"complementary", ATTITUDE_COMPLEMENTARY, 0},
+	{"kalman", ATTITUDE_KALMAN, 0},
+	{"compl + gyro", ATTITUDE_COMPLEMENTARY, 1},
+	{"kalman + gyro", ATTITUDE_KALMAN, 1},
+};
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static double nowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void addEvent(char type, uint64_t timeUs, double x, double y, double z)
+{
+	if (numEvents < MAX_EVENTS) {
+		events[numEvents++] = (Event){type, timeUs, {x, y, z}};
+	}
+}
+
+static int readLog(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[128];
+
+	if (!file) {
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		unsigned long long us;
+		double v[3] = {0};
+		char type;
+
+		if (line[0] == '#' || sscanf(line, "%c,%llu,%lf,%lf,%lf",
+				&type, &us, &v[0], &v[1], &v[2]) < (line[0] == 'm' ? 2 : 4)) {
+			continue;
+		}
+		addEvent(type, us, v[0], v[1], v[2]);
+	}
+
+	fclose(file);
+	return 0;
+}
+
+static void toGravity(double elev_deg, double cant_deg, double g[3])
+{
+	double elev = elev_deg * M_PI / 180;
+	double cant = cant_deg * M_PI / 180;
+
+	g[0] = cos(elev) * sin(cant);
+	g[1] = sin(elev);
+	g[2] = -cos(elev) * cos(cant);
+}
+
+// Attitude of the synthetic rifle, moves take 300 ms
+static void trueAttitude(uint64_t us, double *elev, double *cant)
+{
+	static const double holds[][3] = {
+		// start us, elev, cant
+		{0, 0, 0},
+		{1000000, 5, 10},
+		{5000000, -2, 179.5},
+	};
+	const double moveUs = 300000;
+
+	*elev = holds[0][1];
+	*cant = holds[0][2];
+	for (int i = 1; i < 3; i++) {
+		double f = (us - holds[i][0]) / moveUs;
+		if (f <= 0)
+			break;
+		if (f > 1)
+			f = 1;
+		f = f * f * (3 - 2 * f);
+		*elev = holds[i - 1][1] + f * (holds[i][1] - holds[i - 1][1]);
+		*cant = holds[i - 1][2] + f * (holds[i][2] - holds[i - 1][2]);
+	}
+}
+
+static double uniform()
+{
+	return rand() / (double)RAND_MAX * 2 - 1;
+}
+
+static void makeLog()
+{
+	const double gyroBias[3] = {0.3, -0.2, 0.1};
+	double last[3];
+
+	srand(1);
+	addEvent('t', 0, 0, 0, 0);
+
+	for (uint64_t us = 0; us < LOG_US; us += SAMPLE_US) {
+		double elev, cant, g[3];
+
+		trueAttitude(us, &elev, &cant);
+		toGravity(elev, cant, g);
+
+		if (us == 1000000 || us == 5000000) {
+			addEvent('m', us, 0, 0, 0);
+		} else if (us == 1300000 || us == 5300000) {
+			addEvent('t', us, elev, cant, 0);
+		}
+
+		// Recoil, 4 g back along the bore and 1.5 g sideways, dying out
+		double shock[3] = {0};
+		if (us >= 3000000 && us < 3020000) {
+			double f = 1 - (us - 3000000) / 20000.0;
+			shock[0] = 1.5 * f;
+			shock[1] = -4 * f;
+		}
+
+		// Body rates that turn last into g, the body turns the other way
+		// The gyro covers the time up to the sample, so it goes first
+		if (us > 0) {
+			double axis[3] = {
+				last[1] * g[2] - last[2] * g[1],
+				last[2] * g[0] - last[0] * g[2],
+				last[0] * g[1] - last[1] * g[0],
+			};
+			double length = sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+			double dot = last[0] * g[0] + last[1] * g[1] + last[2] * g[2];
+			double turn = atan2(length, dot);
+			double rate[3];
+
+			for (int i = 0; i < 3; i++) {
+				rate[i] = (length > 0 ? -axis[i] / length * turn : 0)
+						/ (SAMPLE_US * 1e-6) * 180 / M_PI + gyroBias[i] + 0.2 * uniform();
+			}
+			addEvent('g', us, rate[0], rate[1], rate[2]);
+		}
+
+		int16_t counts[3];
+		for (int i = 0; i < 3; i++) {
+			counts[i] = (int16_t)lround((g[i] + shock[i]) * LSB_PER_G + 2 * uniform());
+		}
+		addEvent('a', us, counts[0], counts[1], counts[2]);
+
+		for (int i = 0; i < 3; i++) {
+			last[i] = g[i];
+		}
+	}
+}
+
+static void writeLog(const char *path)
+{
+	FILE *file = fopen(path, "w");
+
+	if (!file) {
+		return;
+	}
+
+	fprintf(file, "# a,us,x,y,z counts | g,us,x,y,z deg/s | t,us,elev,cant deg | m,us\n");
+	for (int i = 0; i < numEvents; i++) {
+		const Event *e = &events[i];
+
+		if (e->type == 'm') {
+			fprintf(file, "m,%llu\n", (unsigned long long)e->timeUs);
+		} else if (e->type == 't') {
+			fprintf(file, "t,%llu,%.3f,%.3f\n", (unsigned long long)e->timeUs,
+					e->value[0], e->value[1]);
+		} else if (e->type == 'a') {
+			fprintf(file, "a,%llu,%.0f,%.0f,%.0f\n", (unsigned long long)e->timeUs,
+					e->value[0], e->value[1], e->value[2]);
+		} else {
+			fprintf(file, "g,%llu,%.3f,%.3f,%.3f\n", (unsigned long long)e->timeUs,
+					e->value[0], e->value[1], e->value[2]);
+		}
+	}
+
+	fclose(file);
+}
+
+static double angleError(double a, double b)
+{
+	return fabs(remainder(a - b, 360));
+}
+
+static void bench(const Filter *filter, int hasTruth)
+{
+	Attitude attitude;
+	int16_t window[AVERAGING_SIZE][3];
+	int numWindow = 0;
+	int64_t sum[3] = {0};
+
+	// Current hold
+	double holdElev = 0, holdCant = 0;
+	uint64_t holdUs = 0;
+	int isHeld = 0;
+	int isSettled = 0;
+	int numInside = 0;
+
+	double maxSettleUs = 0, maxError = 0, sumSq = 0;
+	long numSettled = 0, numSamples = 0;
+	double filterNs = 0;
+
+	Attitude_init(&attitude, filter->filter < 0 ? ATTITUDE_KALMAN : filter->filter);
+
+	for (int i = 0; i < numEvents; i++) {
+		const Event *e = &events[i];
+		double g[3];
+
+		if (e->type == 't' || e->type == 'm') {
+			if (isHeld && !isSettled)
+				maxSettleUs = INFINITY;
+			holdElev = e->value[0];
+			holdCant = e->value[1];
+			holdUs = e->timeUs;
+			isHeld = e->type == 't';
+			isSettled = 0;
+			numInside = 0;
+			continue;
+		}
+
+		if (e->type == 'g') {
+			fix16 rate[3];
+
+			if (!filter->isGyro || filter->filter < 0) {
+				continue;
+			}
+			for (int j = 0; j < 3; j++) {
+				rate[j] = Fix16_fromDouble(e->value[j]);
+			}
+			double start = nowNs();
+			Attitude_addGyro(&attitude, rate, e->timeUs);
+			filterNs += nowNs() - start;
+			continue;
+		}
+
+		int16_t counts[3];
+		for (int j = 0; j < 3; j++) {
+			counts[j] = (int16_t)e->value[j];
+		}
+
+		double start = nowNs();
+		if (filter->filter < 0) {
+			int slot = numSamples % AVERAGING_SIZE;
+			for (int j = 0; j < 3; j++) {
+				if (numWindow == AVERAGING_SIZE)
+					sum[j] -= window[slot][j];
+				window[slot][j] = counts[j];
+				sum[j] += counts[j];
+			}
+			if (numWindow < AVERAGING_SIZE)
+				numWindow++;
+			for (int j = 0; j < 3; j++) {
+				g[j] = sum[j] / (double)numWindow;
+			}
+		} else {
+			int32_t gravity[3];
+			Attitude_addAccel(&attitude, counts, e->timeUs);
+			Attitude_getGravity(&attitude, gravity);
+			for (int j = 0; j < 3; j++) {
+				g[j] = gravity[j] / 256.0;
+			}
+		}
+		filterNs += nowNs() - start;
+		numSamples++;
+
+		double elev = atan2(g[1], sqrt(g[0] * g[0] + g[2] * g[2])) * 180 / M_PI;
+		double cant = atan2(g[0], -g[2]) * 180 / M_PI;
+
+		if (!hasTruth) {
+			holdElev += elev;
+			holdCant += cant;
+			continue;
+		}
+		if (!isHeld) {
+			continue;
+		}
+
+		double elevError = angleError(elev, holdElev);
+		double cantError = angleError(cant, holdCant);
+		double error = elevError > cantError ? elevError : cantError;
+
+		// Settled from the first of SETTLED_SAMPLES in a row inside
+		if (!isSettled) {
+			numInside = error <= SETTLED_DEG ? numInside + 1 : 0;
+			if (numInside == SETTLED_SAMPLES) {
+				double settleUs = e->timeUs - holdUs
+						- (SETTLED_SAMPLES - 1) * (double)SAMPLE_US;
+				isSettled = 1;
+				if (settleUs > maxSettleUs)
+					maxSettleUs = settleUs;
+			}
+			continue;
+		}
+
+		if (error > maxError)
+			maxError = error;
+		sumSq += elevError * elevError + cantError * cantError;
+		numSettled += 2;
+	}
+
+	if (!hasTruth) {
+		printf("%-14s no t lines, mean elev %.3f deg, cant %.3f deg, %6.1f ns/sample\n",
+				filter->name, holdElev / numSamples, holdCant / numSamples,
+				filterNs / numSamples);
+		return;
+	}
+
+	printf("%-14s settle %7.1f ms  noise %.4f deg rms  max error %6.3f deg  %6.1f ns/sample\n",
+			filter->name, maxSettleUs / 1000.0,
+			numSettled ? sqrt(sumSq / numSettled) : 0, maxError,
+			filterNs / numSamples);
+}
+
+/*--------------------------------------------------------------*/
+/* Main Function												*/
+/*--------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	const char *logPath = NULL;
+	const char *writePath = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			writePath = argv[++i];
+		} else {
+			logPath = argv[i];
+		}
+	}
+
+	if (logPath) {
+		if (readLog(logPath) < 0) {
+			fprintf(stderr, "can't read %s\n", logPath);
+			return 1;
+		}
+	} else {
+		makeLog();
+	}
+
+	if (writePath) {
+		writeLog(writePath);
+	}
+
+	int hasTruth = 0;
+	for (int i = 0; i < numEvents; i++) {
+		if (events[i].type == 't' || events[i].type == 'm')
+			hasTruth = 1;
+	}
+
+	printf("%d log entries, settled within %.1f deg\n", numEvents, SETTLED_DEG);
+	for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+		bench(&filters[i], hasTruth);
+	}
+
+	return 0;
+}
@@ -0,0 +1,281 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - bench_ballistics.c												   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains a host benchmark that compares the ballistics paths
+/	against the analytic one for speed and for the largest pixel difference
+/	over 0 - 180 m, the table's elevation range and every cant.
+/	Exits with 1 if the fixed point path is off by more than 1 pixel.
+/
+/	Angles a hair below 0, which the cant sits either side of all the time,
+/	are checked on their own since the grid steps over them; every path
+/	must be within 1 pixel of the analytic one there.
+/
+/	It then checks the values of Ballistics_solve() against what they are
+/	worked out from. With the bore along the line of sight and no height
+/	over bore, a level shot's drop and time of flight are those of the drag
+/	solver (Trajectory_solve). The speed is the range table's, the lead is
+/	the time of flight over metres per Q8, and a target moving along the
+/	line of sight is met at d + v*t. Exits with 1 if any of them is off.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ballistics.h"
+#include "profile.h"
+#include "trajectory.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define DIST_MAX_M 180.0
+#define DIST_STEP_M 0.25
+#define ELEV_MAX_DEG 60.0
+#define ELEV_STEP_DEG 1.0
+#define CANT_MAX_DEG 180.0
+#define CANT_STEP_DEG 5.0
+
+#define FIXED_MAX_ERROR_PX 1
+
+// Just below 0, wraps to 360 in the table path's trig
+#define EDGE_ANGLE_DEG -1e-6
+#define EDGE_STEP_M 10
+
+// Ballistics_solve() check
+#define SOLVE_STEP_M 10
+#define SOLVE_SPEED_MPS 5.0
+#define SOLVE_MAX_TIME_ERROR_S 0.0001
+#define SOLVE_MAX_DROP_ERROR_M 0.002		// Plus one Q8 step at the target
+#define SOLVE_EPSILON 1e-9
+
+typedef struct {
+	double distance_m;
+	double elev_deg;
+	double cant_deg;
+} Point;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static double nowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static Point *buildGrid(long *numPoints)
+{
+	long n = 0;
+	long capacity = (long)((DIST_MAX_M / DIST_STEP_M + 1)
+			* (2 * ELEV_MAX_DEG / ELEV_STEP_DEG + 1)
+			* (2 * CANT_MAX_DEG / CANT_STEP_DEG + 1)) + 1;
+	Point *points = malloc(capacity * sizeof(Point));
+
+	for (double d = 0; d <= DIST_MAX_M; d += DIST_STEP_M) {
+		for (double e = -ELEV_MAX_DEG; e <= ELEV_MAX_DEG; e += ELEV_STEP_DEG) {
+			for (double c = -CANT_MAX_DEG; c < CANT_MAX_DEG; c += CANT_STEP_DEG) {
+				points[n].distance_m = d;
+				points[n].elev_deg = e;
+				points[n].cant_deg = c;
+				n++;
+			}
+		}
+	}
+
+	*numPoints = n;
+	return points;
+}
+
+// Runs every point through the current mode, returns ns per call
+static double run(const Point *points, long n, int *x, int *z)
+{
+	double start = nowNs();
+
+	for (long i = 0; i < n; i++) {
+		Ballistics_calculatePixelOffset(points[i].distance_m, points[i].elev_deg,
+				points[i].cant_deg, &x[i], &z[i]);
+	}
+
+	return (nowNs() - start) / n;
+}
+
+// Returns the largest pixel difference
+static int compare(const char *name, BallisticsMode mode, const Point *points, long n,
+		const int *xRef, const int *zRef, double refNs)
+{
+	int *x = malloc(n * sizeof(int));
+	int *z = malloc(n * sizeof(int));
+	int maxError = 0;
+	long numDiff = 0;
+	long worst = 0;
+
+	Ballistics_setMode(mode);
+	double ns = run(points, n, x, z);
+
+	for (long i = 0; i < n; i++) {
+		int error = abs(x[i] - xRef[i]);
+		if (abs(z[i] - zRef[i]) > error)
+			error = abs(z[i] - zRef[i]);
+
+		if (error > 0)
+			numDiff++;
+		if (error > maxError) {
+			maxError = error;
+			worst = i;
+		}
+	}
+
+	printf("%-10s %8.1f ns/call  %5.2fx  max error %d px  (%.3f%% of points differ)\n",
+			name, ns, refNs / ns, maxError, 100.0 * numDiff / n);
+	if (maxError > 0) {
+		printf("           worst at %.2f m, elev %.0f deg, cant %.0f deg\n",
+				points[worst].distance_m, points[worst].elev_deg, points[worst].cant_deg);
+	}
+
+	free(x);
+	free(z);
+	return maxError;
+}
+
+// Offsets at elevation and cant EDGE_ANGLE_DEG on every path against the
+// analytic one, returns the number of points more than 1 pixel off
+static int checkEdges()
+{
+	static const BallisticsMode modes[] = {BALLISTICS_TABLE, BALLISTICS_FIXED};
+	static const char *names[] = {"table", "fixed"};
+	int numErrors = 0;
+
+	for (int d = EDGE_STEP_M; d <= DIST_MAX_M; d += EDGE_STEP_M) {
+		int xRef, zRef;
+
+		Ballistics_setMode(BALLISTICS_ANALYTIC);
+		Ballistics_calculatePixelOffset(d, EDGE_ANGLE_DEG, EDGE_ANGLE_DEG, &xRef, &zRef);
+
+		for (int i = 0; i < 2; i++) {
+			int x, z;
+
+			Ballistics_setMode(modes[i]);
+			Ballistics_calculatePixelOffset(d, EDGE_ANGLE_DEG, EDGE_ANGLE_DEG, &x, &z);
+			if (abs(x - xRef) > 1 || abs(z - zRef) > 1) {
+				printf("edge       %s at %d m is (%d, %d), expected (%d, %d)\n", names[i], d,
+						x, z, xRef, zRef);
+				numErrors++;
+			}
+		}
+	}
+
+	printf("%-10s %d points off at %g deg\n", "edge", numErrors, EDGE_ANGLE_DEG);
+	return numErrors;
+}
+
+// Reports a value that is off, returns 1 if it is
+static int checkValue(const char *what, double distance_m, double value, double expected,
+		double tolerance)
+{
+	if (fabs(value - expected) <= tolerance) {
+		return 0;
+	}
+
+	printf("solve      %s at %.0f m is %.6f, expected %.6f\n", what, distance_m, value,
+			expected);
+	return 1;
+}
+
+// Checks the solution record of a level shot with a flat profile at every
+// SOLVE_STEP_M, returns the number of values that are off
+static int checkSolve()
+{
+	Profile flat = *Profile_getActive();
+	int numErrors = 0;
+
+	flat.elevBias_rad = 0;
+	flat.heightOverBore_m = 0;
+	Ballistics_setProfile(&flat);
+	Ballistics_setMode(BALLISTICS_ANALYTIC);
+
+	double eyeToOptic = flat.eyeToOptic_m;
+	double pixelsPerMetre = 1.0 / flat.pixelWidth_m;
+
+	for (int d = SOLVE_STEP_M; d <= DIST_MAX_M; d += SOLVE_STEP_M) {
+		BallisticsSolution solution;
+		double time_s, drop_m;
+
+		Trajectory_solve(&flat.load, d, &time_s, &drop_m);
+		Ballistics_solve(d, 0, 0, 0, &solution);
+
+		double metresPerQ8 = (d + eyeToOptic)
+				/ (eyeToOptic * pixelsPerMetre * (1 << BALLISTICS_Q8_SHIFT));
+
+		numErrors += checkValue("time_s", d, solution.time_s, time_s,
+				SOLVE_MAX_TIME_ERROR_S);
+		numErrors += checkValue("drop_m", d, solution.drop_m, drop_m,
+				SOLVE_MAX_DROP_ERROR_M + metresPerQ8);
+		numErrors += checkValue("drift_m", d, solution.drift_m, 0, metresPerQ8);
+		numErrors += checkValue("velocity_mps", d, solution.velocity_mps,
+				Trajectory_lookupVelocity(d), SOLVE_EPSILON);
+		numErrors += checkValue("leadPerMps_q8", d, solution.leadPerMps_q8,
+				solution.time_s / metresPerQ8, 1);
+		numErrors += checkValue("impactDistance_m", d, solution.impactDistance_m, d,
+				SOLVE_EPSILON);
+
+		// Away and closing, met where the target is after the flight to d
+		for (int sign = -1; sign <= 1; sign += 2) {
+			BallisticsSolution moving;
+			double v = sign * SOLVE_SPEED_MPS;
+
+			Ballistics_solve(d, v, 0, 0, &moving);
+			numErrors += checkValue("impactDistance_m moving", d, moving.impactDistance_m,
+					d + v * solution.time_s, SOLVE_EPSILON);
+			numErrors += checkValue("velocity_mps moving", d, moving.velocity_mps,
+					Trajectory_lookupVelocity(moving.impactDistance_m), SOLVE_EPSILON);
+		}
+	}
+
+	printf("%-10s %d values off\n", "solve", numErrors);
+
+	Ballistics_setProfile(Profile_getActive());
+	return numErrors;
+}
+
+/*--------------------------------------------------------------*/
+/* Main Function												*/
+/*--------------------------------------------------------------*/
+
+int main()
+{
+	long n;
+	Point *points = buildGrid(&n);
+	int *xRef = malloc(n * sizeof(int));
+	int *zRef = malloc(n * sizeof(int));
+
+	double start = nowNs();
+	Ballistics_setup();
+	printf("Ballistics_setup   %8.1f us\n", (nowNs() - start) / 1000.0);
+	printf("%ld points\n", n);
+
+	Ballistics_setMode(BALLISTICS_ANALYTIC);
+	double refNs = run(points, n, xRef, zRef);
+	printf("%-10s %8.1f ns/call\n", "analytic", refNs);
+
+	compare("table", BALLISTICS_TABLE, points, n, xRef, zRef, refNs);
+	int fixedError = compare("fixed", BALLISTICS_FIXED, points, n, xRef, zRef, refNs);
+	int numEdgeErrors = checkEdges();
+	int numSolveErrors = checkSolve();
+
+	free(points);
+	free(xRef);
+	free(zRef);
+	return fixedError > FIXED_MAX_ERROR_PX || numEdgeErrors > 0 || numSolveErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,430 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - bench_kernels.c													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the host micro-benchmark suite. It times the
+/	firmware's inner kernels one at a time against the simulated
+/	peripherals:
+/		ballistics_*	Ballistics_calculatePixelOffset over a distance,
+/						elevation and cant grid, per path
+/		solve_*			Ballistics_solve on the same grid with the fixed
+/						path, standing and with a radial lead
+/		accel_*			Accel_poll per sample, per angle filter
+/		lidar_poll		Lidar_distancePoll per frame (parser and filter)
+/		oled_*			each OLED draw routine, and the flush it causes
+/		oled_hud_idle	every HUD field redrawn with an unchanged value
+/	Next to the host ns per operation it counts, per operation, the SPI
+/	bytes and chip selects of the flush after the call and the libm calls
+/	(sin, cos, atan, atan2, sqrt, round), which are wrapped at link time.
+/	Those counts don't depend on the host, so they catch a regression that
+/	the timing is too noisy to show.
+/
+/	Usage: ifobs_bench_kernels [-o results.csv] [-b baseline.csv]
+/	-o writes the results as CSV, -b compares against an earlier -o file
+/	and exits with 1 if any count per operation went up.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hal.h"
+#include "accelerometer.h"
+#include "ballistics.h"
+#include "lidar.h"
+#include "oled.h"
+#include "sim.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define DIST_MAX_M 180
+#define DIST_STEP_M 5
+#define ELEV_MAX_DEG 45
+#define ELEV_STEP_DEG 15
+#define CANT_MAX_DEG 180
+#define CANT_STEP_DEG 30
+#define BALLISTICS_REPEAT 20
+
+// Polls of about 40 accelerometer samples or 10 LIDAR frames each
+#define NUM_POLLS 200
+#define ACCEL_POLL_MS 100
+#define LIDAR_POLL_MS 40
+
+#define OLED_REPEAT 500
+
+#define MAX_RESULTS 32
+#define NAME_LEN 32
+
+typedef struct {
+	char name[NAME_LEN];
+	double nsPerOp;
+	long ops;
+	double spiBytesPerOp;
+	double csTogglesPerOp;
+	double libmPerOp;
+} Result;
+
+// Counts taken around an operation
+typedef struct {
+	double ns;
+	SimStats stats;
+	unsigned long libmCalls;
+} Mark;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static unsigned long libmCalls = 0;
+
+static Result results[MAX_RESULTS];
+static int numResults = 0;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+// libm, counted (-Wl,--wrap in CMakeLists.txt)
+double __real_sin(double x);
+double __real_cos(double x);
+double __real_atan(double x);
+double __real_atan2(double y, double x);
+double __real_sqrt(double x);
+float __real_sqrtf(float x);
+double __real_round(double x);
+
+double __wrap_sin(double x) { libmCalls++; return __real_sin(x); }
+double __wrap_cos(double x) { libmCalls++; return __real_cos(x); }
+double __wrap_atan(double x) { libmCalls++; return __real_atan(x); }
+double __wrap_atan2(double y, double x) { libmCalls++; return __real_atan2(y, x); }
+double __wrap_sqrt(double x) { libmCalls++; return __real_sqrt(x); }
+float __wrap_sqrtf(float x) { libmCalls++; return __real_sqrtf(x); }
+double __wrap_round(double x) { libmCalls++; return __real_round(x); }
+
+static double nowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static Result *addResult(const char *name, long ops)
+{
+	Result *result = &results[numResults++];
+
+	memset(result, 0, sizeof(*result));
+	snprintf(result->name, NAME_LEN, "%s", name);
+	result->ops = ops;
+	return result;
+}
+
+static void printResult(const Result *result)
+{
+	printf("%-22s %9.1f ns/op %8ld ops %8.1f spi bytes %5.2f cs %6.2f libm\n",
+			result->name, result->nsPerOp, result->ops, result->spiBytesPerOp,
+			result->csTogglesPerOp, result->libmPerOp);
+}
+
+static void benchBallistics(const char *name, BallisticsMode mode)
+{
+	volatile int sink = 0;
+	long ops = 0;
+	unsigned long startCalls = libmCalls;
+	double ns = 0;
+
+	Ballistics_setMode(mode);
+
+	for (int r = 0; r < BALLISTICS_REPEAT; r++) {
+		double start = nowNs();
+		for (int d = 0; d <= DIST_MAX_M; d += DIST_STEP_M) {
+			for (int e = -ELEV_MAX_DEG; e <= ELEV_MAX_DEG; e += ELEV_STEP_DEG) {
+				for (int c = -CANT_MAX_DEG; c < CANT_MAX_DEG; c += CANT_STEP_DEG) {
+					int x, z;
+					Ballistics_calculatePixelOffset(d, e, c, &x, &z);
+					sink += x + z;
+					ops++;
+				}
+			}
+		}
+		ns += nowNs() - start;
+	}
+	(void)sink;
+
+	Result *result = addResult(name, ops);
+	result->nsPerOp = ns / ops;
+	result->libmPerOp = (double)(libmCalls - startCalls) / ops;
+}
+
+static void benchSolve(const char *name, double radialVelocity_mps)
+{
+	volatile double sink = 0;
+	long ops = 0;
+	unsigned long startCalls = libmCalls;
+	double ns = 0;
+
+	Ballistics_setMode(BALLISTICS_FIXED);
+
+	for (int r = 0; r < BALLISTICS_REPEAT; r++) {
+		double start = nowNs();
+		for (int d = 0; d <= DIST_MAX_M; d += DIST_STEP_M) {
+			for (int e = -ELEV_MAX_DEG; e <= ELEV_MAX_DEG; e += ELEV_STEP_DEG) {
+				for (int c = -CANT_MAX_DEG; c < CANT_MAX_DEG; c += CANT_STEP_DEG) {
+					BallisticsSolution solution;
+					Ballistics_solve(d, radialVelocity_mps, e, c, &solution);
+					sink += solution.time_s + solution.xOffset_q8;
+					ops++;
+				}
+			}
+		}
+		ns += nowNs() - start;
+	}
+	(void)sink;
+
+	Result *result = addResult(name, ops);
+	result->nsPerOp = ns / ops;
+	result->libmPerOp = (double)(libmCalls - startCalls) / ops;
+}
+
+static void benchAccel(const char *name, AccelFilter filter)
+{
+	long ops = 0;
+	unsigned long calls = 0;
+	double ns = 0;
+
+	Accel_setFilter(filter);
+
+	for (int i = 0; i < NUM_POLLS; i++) {
+		// Virtual time, the samples pile up in the queue
+		uint64_t before = Sim_getStats().accelSamples;
+		Hal_sleepMs(ACCEL_POLL_MS);
+
+		unsigned long startCalls = libmCalls;
+		double start = nowNs();
+		Accel_poll();
+		ns += nowNs() - start;
+		calls += libmCalls - startCalls;
+
+		// Samples taken during the sleep, give or take the few still in
+		// the ADXL343's FIFO
+		ops += (long)(Sim_getStats().accelSamples - before);
+
+		// Untimed, keeps the LIDAR ring from overflowing
+		Lidar_distancePoll();
+	}
+
+	Result *result = addResult(name, ops);
+	result->nsPerOp = ns / ops;
+	result->libmPerOp = (double)calls / ops;
+}
+
+static void benchLidar()
+{
+	long ops = 0;
+	unsigned long calls = 0;
+	double ns = 0;
+
+	for (int i = 0; i < NUM_POLLS; i++) {
+		Hal_sleepMs(LIDAR_POLL_MS);
+		uint32_t before = Lidar_getFrameCount();
+
+		unsigned long startCalls = libmCalls;
+		double start = nowNs();
+		Lidar_distancePoll();
+		ns += nowNs() - start;
+		calls += libmCalls - startCalls;
+
+		ops += Lidar_getFrameCount() - before;
+
+		// Untimed, keeps the accelerometer queue from overflowing
+		Accel_poll();
+	}
+
+	Result *result = addResult("lidar_poll", ops);
+	result->nsPerOp = ns / ops;
+	result->libmPerOp = (double)calls / ops;
+}
+
+static Mark mark()
+{
+	Mark m = {nowNs(), Sim_getStats(), libmCalls};
+	return m;
+}
+
+// Times draw(i) on its own, then counts what the flush after it sends
+static void benchOled(const char *name, void (*draw)(int i))
+{
+	double ns = 0;
+	unsigned long calls = 0;
+	uint64_t spiBytes = 0;
+	uint64_t csToggles = 0;
+
+	for (int i = 0; i < OLED_REPEAT; i++) {
+		Mark start = mark();
+		draw(i);
+		Mark end = mark();
+
+		Oled_flush();
+		Oled_waitFlush();
+		Mark flushed = mark();
+
+		ns += end.ns - start.ns;
+		calls += end.libmCalls - start.libmCalls;
+		spiBytes += flushed.stats.spiBytes[HAL_SPI0] - end.stats.spiBytes[HAL_SPI0];
+		csToggles += flushed.stats.csToggles[HAL_SPI0] - end.stats.csToggles[HAL_SPI0];
+	}
+
+	Result *result = addResult(name, OLED_REPEAT);
+	result->nsPerOp = ns / OLED_REPEAT;
+	result->libmPerOp = (double)calls / OLED_REPEAT;
+	result->spiBytesPerOp = (double)spiBytes / OLED_REPEAT;
+	result->csTogglesPerOp = (double)csToggles / OLED_REPEAT;
+}
+
+// Arguments that change every call, so each one redraws
+static void drawDistance(int i) { Oled_displayDistance(100 * (i % 180)); }
+static void drawElevation(int i) { Oled_displayElevation((i % 180) - 90 + 0.37); }
+static void drawCant(int i) { Oled_displayCant((i % 360) - 180 + 0.37); }
+static void drawDot(int i) { Oled_displayCalcDot((i % 21) - 10, i % 30); }
+static void drawReticle(int i) { Oled_displayReticle(((i % 21) - 10) * 256 + i % 7 * 37, i % 30 * 256 + 128); }
+static void drawLock(int i) { if (i % 2) Oled_displayLock(); else Oled_clearLock(); }
+static void drawDotErr(int i) { if (i % 2) Oled_displayCalcDotErr(); else Oled_clearCalcDotErr(); }
+static void drawCenter(int i) { (void)i; Oled_displayCenter(); }
+
+// The whole HUD with nothing changed, after the first call it should send nothing
+static void drawIdle(int i)
+{
+	(void)i;
+	Oled_clearLock();
+	Oled_displayDistance(12345);
+	Oled_displayElevation(1.5);
+	Oled_displayCant(-2.5);
+	Oled_displayCalcDot(3, 4);
+}
+
+static void writeResults(const char *path)
+{
+	FILE *file = fopen(path, "w");
+
+	if (!file) {
+		fprintf(stderr, "can't write %s\n", path);
+		return;
+	}
+
+	fprintf(file, "kernel,ns_per_op,ops,spi_bytes_per_op,cs_toggles_per_op,libm_per_op\n");
+	for (int i = 0; i < numResults; i++) {
+		const Result *result = &results[i];
+		fprintf(file, "%s,%.1f,%ld,%.2f,%.2f,%.2f\n", result->name, result->nsPerOp,
+				result->ops, result->spiBytesPerOp, result->csTogglesPerOp,
+				result->libmPerOp);
+	}
+	fclose(file);
+}
+
+// Returns the number of kernels whose counts went up
+static int compareResults(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[256];
+	int numWorse = 0;
+
+	if (!file) {
+		fprintf(stderr, "can't read %s\n", path);
+		return 1;
+	}
+
+	printf("\nagainst %s:\n", path);
+	while (fgets(line, sizeof(line), file)) {
+		Result base;
+		if (sscanf(line, "%31[^,],%lf,%ld,%lf,%lf,%lf", base.name, &base.nsPerOp,
+				&base.ops, &base.spiBytesPerOp, &base.csTogglesPerOp,
+				&base.libmPerOp) != 6) {
+			continue;
+		}
+
+		for (int i = 0; i < numResults; i++) {
+			const Result *result = &results[i];
+			if (strcmp(result->name, base.name) != 0) {
+				continue;
+			}
+
+			// Half the last printed digit of slack for the rounding
+			bool isWorse = result->spiBytesPerOp > base.spiBytesPerOp + 0.005
+					|| result->csTogglesPerOp > base.csTogglesPerOp + 0.005
+					|| result->libmPerOp > base.libmPerOp + 0.005;
+			printf("%-22s %6.2fx time%s\n", result->name,
+					result->nsPerOp / base.nsPerOp, isWorse ? "  MORE WORK" : "");
+			numWorse += isWorse ? 1 : 0;
+		}
+	}
+
+	fclose(file);
+	return numWorse;
+}
+
+/*--------------------------------------------------------------*/
+/* Main Function												*/
+/*--------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	const char *outPath = NULL;
+	const char *basePath = NULL;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-o") == 0) {
+			outPath = argv[i + 1];
+		} else if (strcmp(argv[i], "-b") == 0) {
+			basePath = argv[i + 1];
+		}
+	}
+
+	Hal_init();
+	Accel_setup();
+	Lidar_setup();
+	Oled_setup();
+	Ballistics_setup();
+	printf("\n");
+
+	benchBallistics("ballistics_analytic", BALLISTICS_ANALYTIC);
+	benchBallistics("ballistics_table", BALLISTICS_TABLE);
+	benchBallistics("ballistics_fixed", BALLISTICS_FIXED);
+	benchSolve("solve_fixed", 0);
+	benchSolve("solve_fixed_lead", -5);
+
+	benchAccel("accel_average", ACCEL_FILTER_AVERAGE);
+	benchAccel("accel_complementary", ACCEL_FILTER_COMPLEMENTARY);
+	benchAccel("accel_kalman", ACCEL_FILTER_KALMAN);
+
+	benchLidar();
+
+	benchOled("oled_distance", drawDistance);
+	benchOled("oled_elevation", drawElevation);
+	benchOled("oled_cant", drawCant);
+	benchOled("oled_dot", drawDot);
+	benchOled("oled_reticle", drawReticle);
+	benchOled("oled_lock", drawLock);
+	benchOled("oled_dot_err", drawDotErr);
+	benchOled("oled_center", drawCenter);
+	benchOled("oled_hud_idle", drawIdle);
+
+	for (int i = 0; i < numResults; i++) {
+		printResult(&results[i]);
+	}
+
+	// Before writing, the baseline can be the same file
+	int numWorse = basePath ? compareResults(basePath) : 0;
+	if (outPath) {
+		writeResults(outPath);
+	}
+	return numWorse > 0 ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - bench_trajectory.c												   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains a host benchmark for the drag solver. For a few
+/	loads it reports the RK4 steps per second of building the range table,
+/	the largest difference between the table and a direct solve, and the
+/	drop at the LIDAR's range against a vacuum trajectory.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "trajectory.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define NUM_RUNS 200
+#define CHECK_STEP_M 0.37
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static double nowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(const char *name, const AmmoLoad *load)
+{
+	AmmoLoad vacuum = {load->muzzleVelocity, 0, load->dragModel};
+	int steps = 0;
+
+	double start = nowNs();
+	for (int i = 0; i < NUM_RUNS; i++) {
+		steps = Trajectory_setup(load);
+	}
+	double setupNs = (nowNs() - start) / NUM_RUNS;
+
+	double maxTimeError = 0;
+	double maxDropError = 0;
+	for (double d = 0; d <= TRAJECTORY_MAX_DIST_M; d += CHECK_STEP_M) {
+		double t, drop, tRef, dropRef;
+
+		Trajectory_lookup(d, &t, &drop);
+		Trajectory_solve(load, d, &tRef, &dropRef);
+
+		if (fabs(t - tRef) > maxTimeError)
+			maxTimeError = fabs(t - tRef);
+		if (fabs(drop - dropRef) > maxDropError)
+			maxDropError = fabs(drop - dropRef);
+	}
+
+	printf("%-12s %5d steps  %8.1f us/table  %6.2f Msteps/s  table error %.2f us %.3f mm\n",
+			name, steps, setupNs / 1000.0, steps / setupNs * 1000.0,
+			maxTimeError * 1e6, maxDropError * 1e3);
+
+	for (int d = 100; d <= 180; d += 80) {
+		double t, drop, tVac, dropVac;
+
+		Trajectory_solve(load, d, &t, &drop);
+		Trajectory_solve(&vacuum, d, &tVac, &dropVac);
+		printf("             %3d m  tof %.3f s  drop %6.1f mm  (vacuum %6.1f mm)\n",
+				d, t, drop * 1e3, dropVac * 1e3);
+	}
+}
+
+/*--------------------------------------------------------------*/
+/* Main Function												*/
+/*--------------------------------------------------------------*/
+
+int main()
+{
+	AmmoLoad vacuum = {390, 0, DRAG_G1};
+	AmmoLoad g1 = {390, 0.125f, DRAG_G1};
+	AmmoLoad g7 = {390, 0.060f, DRAG_G7};
+
+	bench("vacuum", &vacuum);
+	bench("G1 0.125", &g1);
+	bench("G7 0.060", &g7);
+
+	// Leave the closed form check against the vacuum table
+	Trajectory_setup(&vacuum);
+	double maxError = 0;
+	for (double d = 0; d <= TRAJECTORY_MAX_DIST_M; d += CHECK_STEP_M) {
+		double t, drop;
+		double tRef = d / vacuum.muzzleVelocity;
+
+		Trajectory_lookup(d, &t, &drop);
+		if (fabs(drop - 0.5 * 9.8 * tRef * tRef) > maxError)
+			maxError = fabs(drop - 0.5 * 9.8 * tRef * tRef);
+	}
+	printf("vacuum table against g*t^2/2: max error %.3f mm\n", maxError * 1e3);
+
+	return 0;
+}
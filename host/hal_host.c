@@ -0,0 +1,1016 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - hal_host.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the host implementation of the hardware abstraction
+/	layer. The buses are routed to the simulated devices in this directory
+/	and time is virtual: it only moves on sleeps and while the CPU would be
+/	blocked on a bus, so the simulation runs as fast as the host allows.
+/
+/	DMA transfers deliver their bytes when virtual time reaches the end of
+/	the transfer and then run the completion callback, like the interrupt
+/	would. Any CPU access to the port, or its CS and DC pins, while the
+/	transfer is in flight is counted as an ordering conflict.
+/
+/	Core 1 is a thread. Both cores run their code concurrently, but every
+/	HAL call holds one lock, and virtual time only moves once every running
+/	core is blocked (sleeping, on a bus or in Hal_coreWait()), to the
+/	earliest wake up. Interrupt callbacks run on whichever thread moves
+/	time, while the other core is blocked, as an interrupt would. Like WFE,
+/	Hal_sleepUntilUs() and Hal_coreWait() end early on an interrupt taken
+/	by their core, and time stops moving there so the core wakes on time.
+/
+/	Each pass of the main loop (one Hal_isRunning() call to the next) is a
+/	frame. At exit a report of host CPU time and bus traffic per frame is
+/	printed to stderr. With IFOBS_SIM_SPEED set, Hal_isRunning() holds each
+/	frame back until the host clock has caught up with virtual time.
+/
+/	With IFOBS_SIM_REPLAY set the sensors play a capture (sim_replay.c)
+/	from the start of the main loop, and the loop ends with it.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hal.h"
+#include "sim.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define UART_FIFO_DEPTH 32
+
+#define DEFAULT_FRAMES 100
+#define DEFAULT_DIST_CM 10000
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	bool isEnabled;
+	uint8_t fifo[UART_FIFO_DEPTH];
+	int head;
+	int count;
+	void (*rxIrq)(void);
+	int irqCore;
+} SimUart;
+
+typedef struct {
+	bool isRunning;
+	bool isBlocked;
+	uint64_t wakeNs;		// UINT64_MAX while waiting for an event
+	bool isEventPending;	// SEV or an interrupt
+	bool isWfe;				// Woken by an event as well as at wakeNs
+} SimCore;
+
+typedef struct {
+	bool isActive;
+	const uint8_t *src;
+	uint8_t *dst;			// Received bytes, NULL for a write
+	size_t len;
+	uint64_t doneNs;
+	void (*done)(void);
+	int irqCore;			// Core that first used the port, -1 before
+} SimDma;
+
+static bool isInit = false;
+
+// Cores, core 0 is the main thread
+static pthread_mutex_t halLock;
+static pthread_cond_t timeCond = PTHREAD_COND_INITIALIZER;
+static SimCore cores[2] = {{.isRunning = true}};
+static pthread_t core1Thread;
+static void (*core1Entry)(void);
+static __thread int coreId = 0;
+static bool printScreen = false;
+
+// GPIO state
+static bool pinLevel[SIM_NUM_PINS];
+static bool pinIsOut[SIM_NUM_PINS];
+static bool pinIsPullUp[SIM_NUM_PINS];
+static bool pinIsDriven[SIM_NUM_PINS];	// Set by Sim_setPin (buttons)
+static bool pinDrivenLevel[SIM_NUM_PINS];
+static void (*gpioIrq[SIM_NUM_PINS])(void);
+static int gpioIrqCore[SIM_NUM_PINS];
+
+static uint32_t spiBaudrate[2] = {1000000, 1000000};
+static SimUart uarts[2];
+static SimDma dmas[2] = {{.irqCore = -1}, {.irqCore = -1}};
+
+// Settings flash, saved to IFOBS_SIM_FLASH when set
+static uint8_t flashSector[HAL_FLASH_SECTOR_SIZE];
+static const char *flashPath = NULL;
+
+// Lock button press from IFOBS_SIM_LOCK_MS, UINT64_MAX for none
+#define LOCK_PRESS_NS 100000000ULL
+static uint64_t lockPressNs = UINT64_MAX;
+
+// USB serial output, written to IFOBS_SIM_TRACE when set
+static FILE *traceFile = NULL;
+
+// Virtual seconds per host second from IFOBS_SIM_SPEED, 0 to run flat out
+static double speed = 0;
+
+// USB serial input from IFOBS_SIM_SERIAL
+static const char *serialInput = "";
+
+// Virtual time
+static uint64_t nowNs = 0;
+static uint64_t sleptNs = 0;
+
+static SimStats stats;
+
+// Frame accounting
+static long maxFrames = DEFAULT_FRAMES;
+static long numFrames = -1;		// -1 until the first Hal_isRunning()
+static uint64_t frameStartHostNs;
+static uint64_t frameStartNs;
+static uint64_t frameStartSleptNs;
+static uint64_t hostNsMin = UINT64_MAX, hostNsMax = 0, hostNsSum = 0;
+static uint64_t simNsMax = 0, simNsSum = 0;
+static SimStats loopStartStats;
+static uint64_t loopStartHostNs;
+static uint64_t loopStartNs;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static uint64_t hostNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void lock()
+{
+	pthread_mutex_lock(&halLock);
+}
+
+static void unlock()
+{
+	pthread_mutex_unlock(&halLock);
+}
+
+static void advanceNs(uint64_t ns);
+
+static bool isWoken(const SimCore *core)
+{
+	if (core->wakeNs == UINT64_MAX || core->isWfe) {
+		if (core->isEventPending)
+			return true;
+	}
+	return nowNs >= core->wakeNs;
+}
+
+// A blocked core can carry on
+static bool isAnyWoken()
+{
+	for (int i = 0; i < 2; i++) {
+		if (cores[i].isRunning && cores[i].isBlocked && isWoken(&cores[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Interrupt entry on a core, wakes it from WFE
+static void takeIrq(int core)
+{
+	cores[core].isEventPending = true;
+}
+
+// Every running core is blocked, time can move. A core that has been woken
+// but not yet taken the lock back still counts as running.
+static bool isAllBlocked()
+{
+	for (int i = 0; i < 2; i++) {
+		if (cores[i].isRunning && (!cores[i].isBlocked || isWoken(&cores[i]))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Blocks the calling core until wakeNs, or until Hal_coreSignal() when
+// wakeNs is UINT64_MAX. Called with the lock held once.
+static void blockUntil(uint64_t wakeNs)
+{
+	SimCore *core = &cores[coreId];
+
+	core->wakeNs = wakeNs;
+	core->isBlocked = true;
+
+	while (!isWoken(core)) {
+		if (isAllBlocked()) {
+			uint64_t nextNs = UINT64_MAX;
+
+			for (int i = 0; i < 2; i++) {
+				if (cores[i].isRunning && cores[i].wakeNs < nextNs)
+					nextNs = cores[i].wakeNs;
+			}
+
+			// Both cores waiting on each other, nothing will ever wake them
+			if (nextNs == UINT64_MAX) {
+				break;
+			}
+
+			advanceNs(nextNs - nowNs);
+			pthread_cond_broadcast(&timeCond);
+		} else {
+			pthread_cond_wait(&timeCond, &halLock);
+		}
+	}
+
+	core->isBlocked = false;
+	if (wakeNs == UINT64_MAX) {
+		core->isEventPending = false;
+	}
+}
+
+static void *core1Main(void *arg)
+{
+	(void)arg;
+	coreId = 1;
+
+	core1Entry();
+
+	// Wakes Hal_joinCore1()
+	lock();
+	cores[1].isRunning = false;
+	cores[0].isEventPending = true;
+	pthread_cond_broadcast(&timeCond);
+	unlock();
+
+	return NULL;
+}
+
+static long envLong(const char *name, long fallback)
+{
+	const char *value = getenv(name);
+	return value ? strtol(value, NULL, 0) : fallback;
+}
+
+static double envDouble(const char *name, double fallback)
+{
+	const char *value = getenv(name);
+	return value ? strtod(value, NULL) : fallback;
+}
+
+// LIDAR byte arriving on UART1
+static void uartRx(uint8_t byte)
+{
+	SimUart *uart = &uarts[HAL_UART1];
+
+	stats.uartRxBytes++;
+	if (!uart->isEnabled) {
+		return;
+	}
+
+	if (uart->count >= UART_FIFO_DEPTH) {
+		stats.uartOverruns++;
+		return;
+	}
+
+	uart->fifo[(uart->head + uart->count) % UART_FIFO_DEPTH] = byte;
+	uart->count++;
+
+	if (uart->rxIrq) {
+		takeIrq(uart->irqCore);
+		uart->rxIrq();
+	}
+}
+
+static uint64_t spiNs(HalSpi spi, size_t len)
+{
+	return (uint64_t)len * 8 * 1000000000ULL / spiBaudrate[spi];
+}
+
+static void drivePin(uint32_t pin, bool level);
+
+static uint8_t spiTransfer(HalSpi spi, uint8_t mosi)
+{
+	if (spi == HAL_SPI0) {
+		SimOled_write(mosi);
+		return 0;
+	}
+
+	// Reading the FIFO can lower INT1
+	uint8_t miso = SimAdxl343_transfer(mosi);
+	drivePin(SIM_ADXL_PIN_INT1, SimAdxl343_getInt1());
+	return miso;
+}
+
+// The DMA interrupt, the callback may start the next transfer
+static void completeDma(HalSpi spi)
+{
+	SimDma *dma = &dmas[spi];
+
+	for (size_t i = 0; i < dma->len; i++) {
+		uint8_t miso = spiTransfer(spi, dma->src[i]);
+		if (dma->dst)
+			dma->dst[i] = miso;
+	}
+
+	dma->isActive = false;
+	if (dma->done) {
+		takeIrq(dma->irqCore);
+		dma->done();
+	}
+}
+
+// An input driven from outside, calls the GPIO interrupt on a rising edge
+static void drivePin(uint32_t pin, bool level)
+{
+	bool wasHigh = pinIsDriven[pin] && pinDrivenLevel[pin];
+
+	pinIsDriven[pin] = true;
+	pinDrivenLevel[pin] = level;
+
+	if (level && !wasHigh && gpioIrq[pin]) {
+		takeIrq(gpioIrqCore[pin]);
+		gpioIrq[pin]();
+	}
+}
+
+// Brings the sensors up to nowNs
+static void advanceDevices()
+{
+	SimAdxl343_advance(nowNs / 1000);
+	stats.accelSamples = SimAdxl343_getSampleCount();
+	stats.accelLost = SimAdxl343_getLostCount();
+	drivePin(SIM_ADXL_PIN_INT1, SimAdxl343_getInt1());
+
+	SimLidar_advance(nowNs / 1000, uartRx);
+	SimReplay_advance(nowNs / 1000, uartRx);
+
+	if (lockPressNs != UINT64_MAX && nowNs >= lockPressNs) {
+		if (nowNs < lockPressNs + LOCK_PRESS_NS) {
+			drivePin(SIM_BUTTON_PIN_LOCK, false);
+		} else {
+			pinIsDriven[SIM_BUTTON_PIN_LOCK] = false;
+			lockPressNs = UINT64_MAX;
+		}
+	}
+}
+
+static void advanceNs(uint64_t ns)
+{
+	uint64_t targetNs = nowNs + ns;
+
+	// Finish DMA transfers and take ADXL343 samples that happen before the
+	// target in time order, so interrupts see the time they happened at
+	while (true) {
+		int next = -1;
+		uint64_t sampleUs = SimAdxl343_getNextSampleUs();
+		uint64_t eventNs = sampleUs == UINT64_MAX ? UINT64_MAX : sampleUs * 1000;
+
+		for (int i = 0; i < 2; i++) {
+			if (dmas[i].isActive && dmas[i].doneNs < eventNs) {
+				next = i;
+				eventNs = dmas[i].doneNs;
+			}
+		}
+
+		if (eventNs > targetNs) {
+			break;
+		}
+
+		if (eventNs > nowNs) {
+			// Everything due now has happened, an interrupt that woke a
+			// core lets it run from here
+			if (isAnyWoken()) {
+				return;
+			}
+			nowNs = eventNs;
+		}
+		advanceDevices();
+		if (next >= 0) {
+			completeDma(next);
+		}
+	}
+
+	if (isAnyWoken()) {
+		return;
+	}
+
+	nowNs = targetNs;
+	advanceDevices();
+}
+
+// Time the CPU spends blocked while len bytes are clocked out
+static void spiBusy(HalSpi spi, size_t len)
+{
+	uint64_t ns = spiNs(spi, len);
+
+	if (dmas[spi].isActive) {
+		stats.dmaConflicts++;
+	}
+
+	stats.spiBytes[spi] += len;
+	stats.spiBusyNs += ns;
+	blockUntil(nowNs + ns);
+}
+
+static void endFrame()
+{
+	uint64_t hostElapsed = hostNs() - frameStartHostNs;
+	uint64_t simElapsed = (nowNs - frameStartNs) - (sleptNs - frameStartSleptNs);
+
+	if (hostElapsed < hostNsMin)
+		hostNsMin = hostElapsed;
+	if (hostElapsed > hostNsMax)
+		hostNsMax = hostElapsed;
+	hostNsSum += hostElapsed;
+
+	if (simElapsed > simNsMax)
+		simNsMax = simElapsed;
+	simNsSum += simElapsed;
+}
+
+static void startFrame()
+{
+	frameStartNs = nowNs;
+	frameStartSleptNs = sleptNs;
+	frameStartHostNs = hostNs();
+}
+
+// Waits until the host clock is speed times behind virtual time
+static void pace()
+{
+	uint64_t dueNs = loopStartHostNs + (uint64_t)((nowNs - loopStartNs) / speed);
+	uint64_t hostNowNs = hostNs();
+
+	if (speed > 0 && dueNs > hostNowNs) {
+		struct timespec ts = {
+			.tv_sec = (time_t)((dueNs - hostNowNs) / 1000000000ULL),
+			.tv_nsec = (long)((dueNs - hostNowNs) % 1000000000ULL),
+		};
+		nanosleep(&ts, NULL);
+	}
+}
+
+static void reportAtExit()
+{
+	Sim_report(stderr);
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Hal_init()
+{
+	if (isInit) {
+		return;
+	}
+	isInit = true;
+
+	// Interrupt callbacks can make HAL calls of their own
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&halLock, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	SimAdxl343_reset();
+	SimLidar_reset();
+	SimOled_reset();
+
+	maxFrames = envLong("IFOBS_SIM_FRAMES", DEFAULT_FRAMES);
+	printScreen = envLong("IFOBS_SIM_SCREEN", 0) == 1;
+	SimLidar_setDistanceCm((int)envLong("IFOBS_SIM_DIST_CM", DEFAULT_DIST_CM));
+	SimLidar_setRangeRate((int)envLong("IFOBS_SIM_RANGE_RATE", 0));
+	SimLidar_setRateHz((int)envLong("IFOBS_SIM_LIDAR_HZ", 100));
+	SimLidar_setBadPercent((int)envLong("IFOBS_SIM_LIDAR_BAD", 0));
+	SimAdxl343_setAngles(envDouble("IFOBS_SIM_ELEV_DEG", 0),
+			envDouble("IFOBS_SIM_CANT_DEG", 0));
+	speed = envDouble("IFOBS_SIM_SPEED", 0);
+
+	if (getenv("IFOBS_SIM_REPLAY")) {
+		if (!SimReplay_load(getenv("IFOBS_SIM_REPLAY"))) {
+			fprintf(stderr, "can't replay %s\n", getenv("IFOBS_SIM_REPLAY"));
+			exit(1);
+		}
+		SimLidar_setStreaming(false);
+		if (!getenv("IFOBS_SIM_FRAMES")) {
+			maxFrames = LONG_MAX;
+		}
+	}
+
+	if (getenv("IFOBS_SIM_LOCK_MS")) {
+		lockPressNs = (uint64_t)envLong("IFOBS_SIM_LOCK_MS", 0) * 1000000ULL;
+	}
+
+	if (getenv("IFOBS_SIM_TRACE")) {
+		traceFile = fopen(getenv("IFOBS_SIM_TRACE"), "wb");
+	}
+
+	if (getenv("IFOBS_SIM_SERIAL")) {
+		serialInput = getenv("IFOBS_SIM_SERIAL");
+	}
+
+	memset(flashSector, 0xFF, sizeof(flashSector));
+	flashPath = getenv("IFOBS_SIM_FLASH");
+	if (flashPath) {
+		FILE *file = fopen(flashPath, "rb");
+		if (file) {
+			size_t numRead = fread(flashSector, 1, sizeof(flashSector), file);
+			(void)numRead;
+			fclose(file);
+		}
+	}
+
+	atexit(reportAtExit);
+}
+
+void Hal_waitForUsbHost()
+{
+	printf("usb host detected!\n");
+}
+
+bool Hal_isRunning()
+{
+	bool isRunning = true;
+
+	lock();
+	if (numFrames < 0) {
+		loopStartStats = stats;
+		loopStartHostNs = hostNs();
+		loopStartNs = nowNs;
+		SimReplay_start(nowNs / 1000);
+	} else {
+		endFrame();
+	}
+	numFrames++;
+
+	if (numFrames >= maxFrames || SimReplay_isDone()) {
+		isRunning = false;
+	} else {
+		pace();
+		startFrame();
+	}
+	unlock();
+
+	return isRunning;
+}
+
+void Hal_gpioInit(uint32_t pin)
+{
+	lock();
+	pinIsOut[pin] = false;
+	pinLevel[pin] = false;
+	unlock();
+}
+
+void Hal_gpioSetDir(uint32_t pin, bool out)
+{
+	lock();
+	pinIsOut[pin] = out;
+	unlock();
+}
+
+void Hal_gpioPut(uint32_t pin, bool value)
+{
+	lock();
+	if ((pin == SIM_OLED_PIN_CS || pin == SIM_OLED_PIN_DC) && dmas[HAL_SPI0].isActive) {
+		stats.dmaConflicts++;
+	}
+	if (pin == SIM_ADXL_PIN_CS && dmas[HAL_SPI1].isActive) {
+		stats.dmaConflicts++;
+	}
+
+	if (pinLevel[pin] && !value) {
+		if (pin == SIM_OLED_PIN_CS)
+			stats.csToggles[HAL_SPI0]++;
+		if (pin == SIM_ADXL_PIN_CS)
+			stats.csToggles[HAL_SPI1]++;
+	}
+	pinLevel[pin] = value;
+
+	if (pin == SIM_ADXL_PIN_CS) {
+		SimAdxl343_select(!value);
+	}
+	SimOled_gpio(pin, value);
+	unlock();
+}
+
+bool Hal_gpioGet(uint32_t pin)
+{
+	bool level;
+
+	lock();
+	if (pinIsOut[pin])
+		level = pinLevel[pin];
+	else if (pinIsDriven[pin])
+		level = pinDrivenLevel[pin];
+	else
+		level = pinIsPullUp[pin];
+	unlock();
+
+	return level;
+}
+
+void Hal_gpioPullUp(uint32_t pin)
+{
+	lock();
+	pinIsPullUp[pin] = true;
+	unlock();
+}
+
+void Hal_gpioSetFunction(uint32_t pin, HalGpioFunc func)
+{
+	(void)pin;
+	(void)func;
+}
+
+void Hal_gpioSetRiseIrq(uint32_t pin, void (*handler)(void))
+{
+	lock();
+	gpioIrq[pin] = handler;
+	gpioIrqCore[pin] = coreId;
+	unlock();
+}
+
+void Hal_spiInit(HalSpi spi, uint32_t baudrate)
+{
+	lock();
+	spiBaudrate[spi] = baudrate;
+	unlock();
+}
+
+void Hal_spiSetFormat(HalSpi spi, uint32_t bits, uint32_t cpol, uint32_t cpha)
+{
+	(void)spi;
+	(void)bits;
+	(void)cpol;
+	(void)cpha;
+}
+
+int Hal_spiWrite(HalSpi spi, const uint8_t *src, size_t len)
+{
+	lock();
+	for (size_t i = 0; i < len; i++) {
+		spiTransfer(spi, src[i]);
+	}
+	spiBusy(spi, len);
+	unlock();
+	return (int)len;
+}
+
+int Hal_spiRead(HalSpi spi, uint8_t repeatedTx, uint8_t *dst, size_t len)
+{
+	lock();
+	for (size_t i = 0; i < len; i++) {
+		dst[i] = spiTransfer(spi, repeatedTx);
+	}
+	spiBusy(spi, len);
+	unlock();
+	return (int)len;
+}
+
+void Hal_spiWriteDma(HalSpi spi, const uint8_t *src, size_t len, void (*done)(void))
+{
+	Hal_spiTransferDma(spi, src, NULL, len, done);
+}
+
+void Hal_spiTransferDma(HalSpi spi, const uint8_t *src, uint8_t *dst, size_t len,
+		void (*done)(void))
+{
+	SimDma *dma = &dmas[spi];
+	uint64_t ns = spiNs(spi, len);
+
+	lock();
+	if (dma->isActive) {
+		stats.dmaConflicts++;
+		completeDma(spi);
+	}
+
+	if (dma->irqCore < 0) {
+		dma->irqCore = coreId;
+	}
+	dma->isActive = true;
+	dma->src = src;
+	dma->dst = dst;
+	dma->len = len;
+	dma->doneNs = nowNs + ns;
+	dma->done = done;
+
+	stats.spiBytes[spi] += len;
+	stats.spiDmaBytes += len;
+	stats.spiDmaNs += ns;
+	unlock();
+}
+
+bool Hal_spiDmaBusy(HalSpi spi)
+{
+	lock();
+	bool isBusy = dmas[spi].isActive;
+	unlock();
+	return isBusy;
+}
+
+void Hal_spiDmaWait(HalSpi spi)
+{
+	lock();
+	while (dmas[spi].isActive) {
+		uint64_t startNs = nowNs;
+
+		blockUntil(dmas[spi].doneNs);
+		stats.spiBusyNs += nowNs - startNs;
+	}
+	unlock();
+}
+
+void Hal_uartInit(HalUart uart, uint32_t baudrate)
+{
+	(void)baudrate;
+	lock();
+	uarts[uart].isEnabled = true;
+	uarts[uart].head = 0;
+	uarts[uart].count = 0;
+	unlock();
+}
+
+bool Hal_uartIsEnabled(HalUart uart)
+{
+	lock();
+	bool isEnabled = uarts[uart].isEnabled;
+	unlock();
+	return isEnabled;
+}
+
+bool Hal_uartIsReadable(HalUart uart)
+{
+	lock();
+	bool isReadable = uarts[uart].count > 0;
+	unlock();
+	return isReadable;
+}
+
+// The TX FIFO isn't modelled, the bytes reach the sensor one byte time
+// apart from now
+void Hal_uartWrite(HalUart uart, const uint8_t *src, size_t len)
+{
+	lock();
+	if (uarts[uart].isEnabled) {
+		stats.uartTxBytes += len;
+		if (uart == HAL_UART1) {
+			SimLidar_receive(src, len, nowNs / 1000);
+		}
+	}
+	unlock();
+}
+
+uint8_t Hal_uartGetc(HalUart uart)
+{
+	SimUart *u = &uarts[uart];
+	uint8_t byte;
+
+	lock();
+
+	// The real uart_getc blocks, the simulation moves time forward instead
+	while (u->count == 0) {
+		blockUntil(nowNs + 1000);
+	}
+
+	byte = u->fifo[u->head];
+	u->head = (u->head + 1) % UART_FIFO_DEPTH;
+	u->count--;
+
+	unlock();
+	return byte;
+}
+
+void Hal_uartSetRxIrq(HalUart uart, void (*handler)(void))
+{
+	lock();
+	uarts[uart].rxIrq = handler;
+	uarts[uart].irqCore = coreId;
+	unlock();
+}
+
+uint64_t Hal_timeUs()
+{
+	lock();
+	uint64_t us = nowNs / 1000;
+	unlock();
+	return us;
+}
+
+void Hal_sleepMs(uint32_t ms)
+{
+	lock();
+	sleptNs += (uint64_t)ms * 1000000;
+	blockUntil(nowNs + (uint64_t)ms * 1000000);
+	unlock();
+}
+
+void Hal_sleepUntilUs(uint64_t us)
+{
+	SimCore *core;
+	uint64_t startNs;
+
+	lock();
+	core = &cores[coreId];
+	startNs = nowNs;
+
+	core->isWfe = true;
+	blockUntil(us * 1000);
+	core->isWfe = false;
+	core->isEventPending = false;
+
+	sleptNs += nowNs - startNs;
+	unlock();
+}
+
+const uint8_t *Hal_flashSector()
+{
+	return flashSector;
+}
+
+void Hal_flashWriteSector(const uint8_t *data, size_t len)
+{
+	if (len > sizeof(flashSector)) {
+		len = sizeof(flashSector);
+	}
+
+	lock();
+	memset(flashSector, 0xFF, sizeof(flashSector));
+	memcpy(flashSector, data, len);
+	stats.flashWrites++;
+
+	if (flashPath) {
+		FILE *file = fopen(flashPath, "wb");
+		if (file) {
+			fwrite(flashSector, 1, sizeof(flashSector), file);
+			fclose(file);
+		}
+	}
+	unlock();
+}
+
+int Hal_serialGetc()
+{
+	int c = -1;
+
+	lock();
+	if (*serialInput != '\0') {
+		c = (unsigned char)*serialInput++;
+	}
+	unlock();
+
+	return c;
+}
+
+size_t Hal_serialWrite(const uint8_t *src, size_t len)
+{
+	lock();
+	stats.serialTxBytes += len;
+	if (traceFile) {
+		fwrite(src, 1, len, traceFile);
+	}
+	unlock();
+
+	return len;
+}
+
+uint32_t Hal_cycleCount()
+{
+	return (uint32_t)hostNs() & HAL_CYCLE_MASK;
+}
+
+uint32_t Hal_cyclesPerUs()
+{
+	return 1000;
+}
+
+void Hal_launchCore1(void (*entry)(void))
+{
+	lock();
+	core1Entry = entry;
+	cores[1].isRunning = true;
+	cores[1].isBlocked = false;
+	cores[1].wakeNs = UINT64_MAX;
+	unlock();
+
+	pthread_create(&core1Thread, NULL, core1Main, NULL);
+}
+
+void Hal_joinCore1()
+{
+	lock();
+	bool isLaunched = core1Entry != NULL;
+	while (cores[1].isRunning) {
+		blockUntil(UINT64_MAX);
+	}
+	unlock();
+
+	if (isLaunched) {
+		pthread_join(core1Thread, NULL);
+		core1Entry = NULL;
+	}
+}
+
+void Hal_coreSignal()
+{
+	lock();
+	cores[!coreId].isEventPending = true;
+	pthread_cond_broadcast(&timeCond);
+	unlock();
+}
+
+void Hal_coreWait()
+{
+	lock();
+	if (!cores[coreId].isEventPending) {
+		blockUntil(UINT64_MAX);
+	}
+	cores[coreId].isEventPending = false;
+	unlock();
+}
+
+void Sim_setPin(uint32_t pin, bool level)
+{
+	lock();
+	drivePin(pin, level);
+	unlock();
+}
+
+void Sim_releasePin(uint32_t pin)
+{
+	lock();
+	pinIsDriven[pin] = false;
+	unlock();
+}
+
+SimStats Sim_getStats()
+{
+	lock();
+	SimStats copy = stats;
+	unlock();
+	return copy;
+}
+
+void Sim_report(FILE *out)
+{
+	long frames = numFrames;
+	uint64_t hostTotal;
+
+	if (printScreen) {
+		SimOled_print(out);
+	}
+
+	if (frames <= 0) {
+		return;
+	}
+	hostTotal = hostNs() - loopStartHostNs;
+
+	fprintf(out, "--- ifobs host simulation: %ld frames ---\n", frames);
+	fprintf(out, "host cpu / frame   : min %.1f us, mean %.1f us, max %.1f us\n",
+			hostNsMin / 1000.0, hostNsSum / 1000.0 / frames, hostNsMax / 1000.0);
+	fprintf(out, "host throughput    : %.0f frames/s\n",
+			frames / (hostTotal / 1e9));
+	fprintf(out, "target bus / frame : mean %.1f us, max %.1f us\n",
+			simNsSum / 1000.0 / frames, simNsMax / 1000.0);
+	fprintf(out, "spi0 oled / frame  : %.1f bytes, %.1f cs toggles\n",
+			(double)(stats.spiBytes[HAL_SPI0] - loopStartStats.spiBytes[HAL_SPI0]) / frames,
+			(double)(stats.csToggles[HAL_SPI0] - loopStartStats.csToggles[HAL_SPI0]) / frames);
+	fprintf(out, "spi blocked / frame: %.1f us\n",
+			(stats.spiBusyNs - loopStartStats.spiBusyNs) / 1000.0 / frames);
+	fprintf(out, "spi dma / frame    : %.1f bytes, %.1f us offloaded, %llu ordering conflicts\n",
+			(double)(stats.spiDmaBytes - loopStartStats.spiDmaBytes) / frames,
+			(stats.spiDmaNs - loopStartStats.spiDmaNs) / 1000.0 / frames,
+			(unsigned long long)stats.dmaConflicts);
+	fprintf(out, "spi1 accel / frame : %.1f bytes, %.1f cs toggles\n",
+			(double)(stats.spiBytes[HAL_SPI1] - loopStartStats.spiBytes[HAL_SPI1]) / frames,
+			(double)(stats.csToggles[HAL_SPI1] - loopStartStats.csToggles[HAL_SPI1]) / frames);
+	fprintf(out, "uart1 lidar        : %llu bytes sent, %llu lost to rx overrun\n",
+			(unsigned long long)(stats.uartRxBytes - loopStartStats.uartRxBytes),
+			(unsigned long long)(stats.uartOverruns - loopStartStats.uartOverruns));
+	fprintf(out, "lidar config       : %llu commands (%llu bytes), now %d Hz\n",
+			(unsigned long long)SimLidar_getCommandCount(),
+			(unsigned long long)stats.uartTxBytes, SimLidar_getRateHz());
+	fprintf(out, "adxl343 samples    : %llu taken, %llu lost to fifo overrun\n",
+			(unsigned long long)(stats.accelSamples - loopStartStats.accelSamples),
+			(unsigned long long)(stats.accelLost - loopStartStats.accelLost));
+	fprintf(out, "flash              : %llu sector writes\n",
+			(unsigned long long)stats.flashWrites);
+	fprintf(out, "usb trace          : %.1f bytes / frame\n",
+			(double)(stats.serialTxBytes - loopStartStats.serialTxBytes) / frames);
+}
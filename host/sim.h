@@ -0,0 +1,140 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - sim.h															   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the simulated
+/	peripherals used by the host build, and the hooks hal_host.c exposes
+/	to drive and inspect the simulation.
+/ ----------------------------------------------------------------------------*/
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// Board wiring seen by the simulated devices, must match the drivers
+#define SIM_OLED_PIN_CS 5
+#define SIM_OLED_PIN_DC 1
+#define SIM_ADXL_PIN_CS 13
+#define SIM_ADXL_PIN_INT1 10
+#define SIM_BUTTON_PIN_LOCK 11
+
+#define SIM_NUM_PINS 30
+
+// Bus counters, accumulated from Hal_init()
+typedef struct {
+	uint64_t spiBytes[2];		// Bytes clocked on SPI0 (OLED) and SPI1 (ADXL343)
+	uint64_t csToggles[2];		// Chip select assertions per SPI port
+	uint64_t spiBusyNs;			// Time the CPU spent blocked on SPI
+	uint64_t spiDmaBytes;		// Bytes sent by DMA, included in spiBytes
+	uint64_t spiDmaNs;			// Bus time handed off to DMA
+	uint64_t dmaConflicts;		// CPU touched a port (or its CS/DC) mid DMA
+	uint64_t uartRxBytes;		// Bytes the LIDAR put on the wire
+	uint64_t uartTxBytes;		// Bytes sent to the LIDAR
+	uint64_t uartOverruns;		// Bytes lost because the RX FIFO was full
+	uint64_t accelSamples;		// Samples the ADXL343 took
+	uint64_t accelLost;			// Samples lost to its full FIFO
+	uint64_t flashWrites;		// Settings sector erase and program cycles
+	uint64_t serialTxBytes;		// Bytes written with Hal_serialWrite
+} SimStats;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Simulation control (hal_host.c)
+// The scenario is read from the environment in Hal_init():
+//	IFOBS_SIM_FRAMES	main loop iterations before Hal_isRunning() fails
+//	IFOBS_SIM_DIST_CM	LIDAR distance
+//	IFOBS_SIM_RANGE_RATE	cm/s the target moves away at, negative comes closer
+//	IFOBS_SIM_LIDAR_HZ	LIDAR frame rate, 0 for a disconnected sensor
+//	IFOBS_SIM_LIDAR_BAD	percent of LIDAR frames with a weak or wrong return
+//	IFOBS_SIM_LOCK_MS	ms after start to press the lock button for 100 ms
+//	IFOBS_SIM_ELEV_DEG	rifle elevation seen by the accelerometer
+//	IFOBS_SIM_CANT_DEG	rifle cant seen by the accelerometer
+//	IFOBS_SIM_SCREEN	print the final OLED contents when set to 1
+//	IFOBS_SIM_SERIAL	characters typed on the USB serial port
+//	IFOBS_SIM_TRACE		file that gets the binary trace (Hal_serialWrite)
+//	IFOBS_SIM_FLASH		file that keeps the settings flash between runs
+//	IFOBS_SIM_REPLAY	capture (capture.h) that replaces the simulated sensors,
+//						the run ends with it unless IFOBS_SIM_FRAMES is set
+//	IFOBS_SIM_SPEED		paces the run at this many times real time, 1 for
+//						the captured speed, unset or 0 runs as fast as it can
+void Sim_setPin(uint32_t pin, bool level);
+void Sim_releasePin(uint32_t pin);
+SimStats Sim_getStats();
+void Sim_report(FILE *out);
+
+// ADXL343 accelerometer on SPI1
+void SimAdxl343_reset();
+void SimAdxl343_setAngles(double elev_deg, double cant_deg);
+void SimAdxl343_select(bool selected);
+uint8_t SimAdxl343_transfer(uint8_t mosi);
+void SimAdxl343_advance(uint64_t toUs);
+
+// Time of the next sample, UINT64_MAX while not measuring
+uint64_t SimAdxl343_getNextSampleUs();
+
+// Level of the INT1 pin, active high
+bool SimAdxl343_getInt1();
+
+// Samples taken, and samples lost to a full FIFO or unread data register
+uint64_t SimAdxl343_getSampleCount();
+uint64_t SimAdxl343_getLostCount();
+
+// TF-series LIDAR on UART1
+void SimLidar_reset();
+void SimLidar_setDistanceCm(int distance_cm);
+// Moves the target away from the sensor at cmPerS from the start, 0 holds it
+void SimLidar_setRangeRate(int cmPerS);
+void SimLidar_setStrength(int strength);
+void SimLidar_setRateHz(int rateHz);
+void SimLidar_setBadPercent(int percent);
+void SimLidar_advance(uint64_t toUs, void (*rx)(uint8_t byte));
+
+// Bytes written to UART1 from atUs on, parsed as configuration commands
+void SimLidar_receive(const uint8_t *data, size_t len, uint64_t atUs);
+
+// Frame rate the sensor is running at, 0 when disconnected
+int SimLidar_getRateHz();
+
+// Configuration commands the sensor acted on
+uint64_t SimLidar_getCommandCount();
+
+// Stops the frames while a replay sends them, commands are still answered
+void SimLidar_setStreaming(bool streaming);
+
+// Sensor replay from a capture (capture.h)
+// Returns false if the file can't be read or has no packets in it
+bool SimReplay_load(const char *path);
+
+// The first packet of the capture lines up with atUs
+void SimReplay_start(uint64_t atUs);
+
+// The accelerometer sample for the model's sample at atUs, false without
+// one to replace it
+bool SimReplay_getAccel(uint64_t atUs, int16_t value[3]);
+
+// Puts the LIDAR bytes due by toUs on the wire
+void SimReplay_advance(uint64_t toUs, void (*rx)(uint8_t byte));
+
+// Every byte and sample has been played
+bool SimReplay_isDone();
+
+// SSD1306-style OLED on SPI0
+void SimOled_reset();
+void SimOled_gpio(uint32_t pin, bool level);
+void SimOled_write(uint8_t byte);
+uint8_t SimOled_getColumn(int page, int col);
+uint8_t SimOled_getContrast();
+void SimOled_print(FILE *out);
+
+#endif
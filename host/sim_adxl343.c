@@ -0,0 +1,315 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - sim_adxl343.c													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains a register level model of the ADXL343 accelerometer
+/	as seen over 4-wire SPI. The gravity vector is derived from a rifle
+/	elevation and cant with a small amount of deterministic noise.
+/
+/	Samples are taken at the BW_RATE output data rate as simulated time
+/	moves. In bypass mode the data registers hold the newest one, in FIFO
+/	and stream mode they go through the 32 entry FIFO and each read of
+/	DATAX0 pops the oldest. The watermark, overrun and data ready bits of
+/	INT_SOURCE follow the FIFO the way the datasheet describes, and drive
+/	INT1 through INT_ENABLE and INT_MAP.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <math.h>
+#include <string.h>
+#include "sim.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define NUM_REGS 0x40
+
+#define REG_DEVID 0x00
+#define REG_BW_RATE 0x2C
+#define REG_POWER_CTL 0x2D
+#define REG_INT_ENABLE 0x2E
+#define REG_INT_MAP 0x2F
+#define REG_INT_SOURCE 0x30
+#define REG_DATAX0 0x32
+#define REG_FIFO_CTL 0x38
+#define REG_FIFO_STATUS 0x39
+
+#define DEVID 0xE5
+#define MEASURE_BIT (1 << 3)
+#define RATE_MASK 0x0F
+#define BW_RATE_DEFAULT 0x0A			// 100 Hz
+
+// INT_SOURCE
+#define DATA_READY_BIT (1 << 7)
+#define WATERMARK_BIT (1 << 1)
+#define OVERRUN_BIT (1 << 0)
+
+// FIFO_CTL
+#define FIFO_MODE_SHIFT 6
+#define FIFO_MODE_BYPASS 0
+#define FIFO_MODE_FIFO 1
+#define SAMPLES_MASK 0x1F
+
+#define FIFO_DEPTH 32
+
+#define LSB_PER_G 256
+#define NOISE_LSB 2
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static uint8_t regs[NUM_REGS];
+
+// Transaction state, reset on every chip select
+static bool isSelected = false;
+static bool isFirstByte = false;
+static bool isRead = false;
+static bool isMultiByte = false;
+static uint8_t addr = 0;
+
+static double gravity[3] = {0, 0, -1};	// In g, device axes
+static uint32_t noiseState = 1;
+
+static int16_t fifo[FIFO_DEPTH][3];
+static int fifoHead = 0;
+static int fifoCount = 0;
+
+static uint64_t nowUs = 0;
+static uint64_t nextSampleUs = 0;
+static uint64_t numSamples = 0;
+static uint64_t numLost = 0;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static int noise()
+{
+	noiseState = noiseState * 1103515245 + 12345;
+	return (int)((noiseState >> 16) % (2 * NOISE_LSB + 1)) - NOISE_LSB;
+}
+
+static bool isMeasuring()
+{
+	return regs[REG_POWER_CTL] & MEASURE_BIT;
+}
+
+static int fifoMode()
+{
+	return regs[REG_FIFO_CTL] >> FIFO_MODE_SHIFT;
+}
+
+// 3200 Hz at rate code 0xF, halving with each step down
+static uint64_t samplePeriodUs()
+{
+	int code = regs[REG_BW_RATE] & RATE_MASK;
+	return (1000000ULL << (0xF - code)) / 3200;
+}
+
+static void setData(const int16_t value[3])
+{
+	for (int i = 0; i < 3; i++) {
+		regs[REG_DATAX0 + 2*i] = (uint8_t)(value[i] & 0xFF);
+		regs[REG_DATAX0 + 2*i + 1] = (uint8_t)((uint16_t)value[i] >> 8);
+	}
+}
+
+static void updateFlags()
+{
+	uint8_t source = regs[REG_INT_SOURCE] & (OVERRUN_BIT | DATA_READY_BIT);
+
+	if (fifoMode() != FIFO_MODE_BYPASS) {
+		source &= ~DATA_READY_BIT;
+		if (fifoCount > 0)
+			source |= DATA_READY_BIT;
+		if (fifoCount >= (regs[REG_FIFO_CTL] & SAMPLES_MASK))
+			source |= WATERMARK_BIT;
+	}
+
+	regs[REG_INT_SOURCE] = source;
+	regs[REG_FIFO_STATUS] = (uint8_t)fifoCount;
+}
+
+// Takes one sample at the output data rate
+static void sample()
+{
+	int16_t value[3];
+	numSamples++;
+
+	if (!SimReplay_getAccel(nowUs, value)) {
+		for (int i = 0; i < 3; i++) {
+			value[i] = (int16_t)lround(gravity[i] * LSB_PER_G) + noise();
+		}
+	}
+
+	if (fifoMode() == FIFO_MODE_BYPASS) {
+		if (regs[REG_INT_SOURCE] & DATA_READY_BIT) {
+			regs[REG_INT_SOURCE] |= OVERRUN_BIT;
+			numLost++;
+		}
+		setData(value);
+		regs[REG_INT_SOURCE] |= DATA_READY_BIT;
+		return;
+	}
+
+	if (fifoCount == FIFO_DEPTH) {
+		regs[REG_INT_SOURCE] |= OVERRUN_BIT;
+		numLost++;
+
+		// FIFO mode stops collecting, stream mode drops the oldest
+		if (fifoMode() == FIFO_MODE_FIFO) {
+			return;
+		}
+		fifoHead = (fifoHead + 1) % FIFO_DEPTH;
+		fifoCount--;
+	}
+
+	int tail = (fifoHead + fifoCount) % FIFO_DEPTH;
+	for (int i = 0; i < 3; i++) {
+		fifo[tail][i] = value[i];
+	}
+	fifoCount++;
+	updateFlags();
+}
+
+// A read of DATAX0 takes the oldest sample out of the FIFO
+static void readData()
+{
+	if (fifoMode() == FIFO_MODE_BYPASS) {
+		regs[REG_INT_SOURCE] &= ~(DATA_READY_BIT | OVERRUN_BIT);
+		return;
+	}
+
+	if (fifoCount > 0) {
+		setData(fifo[fifoHead]);
+		fifoHead = (fifoHead + 1) % FIFO_DEPTH;
+		fifoCount--;
+	}
+	regs[REG_INT_SOURCE] &= ~OVERRUN_BIT;
+	updateFlags();
+}
+
+// Register writes with side effects
+static void writeReg(uint8_t reg, uint8_t value)
+{
+	bool wasMeasuring = isMeasuring();
+
+	regs[reg] = value;
+
+	if (reg == REG_POWER_CTL && isMeasuring() && !wasMeasuring) {
+		nextSampleUs = nowUs + samplePeriodUs();
+	}
+	if (reg == REG_FIFO_CTL) {
+		// Changing the mode clears the FIFO
+		fifoHead = 0;
+		fifoCount = 0;
+		updateFlags();
+	}
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void SimAdxl343_reset()
+{
+	memset(regs, 0, sizeof(regs));
+	regs[REG_DEVID] = DEVID;
+	regs[REG_BW_RATE] = BW_RATE_DEFAULT;
+	isSelected = false;
+	noiseState = 1;
+	fifoHead = 0;
+	fifoCount = 0;
+	nowUs = 0;
+	numSamples = 0;
+	numLost = 0;
+}
+
+// Same convention as cal_Angle in accelerometer.c
+void SimAdxl343_setAngles(double elev_deg, double cant_deg)
+{
+	double elev_rad = elev_deg * M_PI / 180.0;
+	double cant_rad = cant_deg * M_PI / 180.0;
+
+	gravity[0] = cos(elev_rad) * sin(cant_rad);
+	gravity[1] = sin(elev_rad);
+	gravity[2] = -cos(elev_rad) * cos(cant_rad);
+}
+
+void SimAdxl343_select(bool selected)
+{
+	isSelected = selected;
+	isFirstByte = selected;
+}
+
+uint8_t SimAdxl343_transfer(uint8_t mosi)
+{
+	uint8_t miso = 0;
+
+	if (!isSelected) {
+		return 0;
+	}
+
+	// First byte is R/~W, MB, then the 6 bit address
+	if (isFirstByte) {
+		isFirstByte = false;
+		isRead = mosi & 0x80;
+		isMultiByte = mosi & 0x40;
+		addr = mosi & 0x3F;
+
+		if (isRead && addr == REG_DATAX0) {
+			readData();
+		}
+		return 0;
+	}
+
+	if (isRead) {
+		miso = regs[addr];
+	} else if (addr != REG_DEVID && addr != REG_INT_SOURCE && addr != REG_FIFO_STATUS) {
+		writeReg(addr, mosi);
+	}
+
+	if (isMultiByte) {
+		addr = (addr + 1) % NUM_REGS;
+	}
+	return miso;
+}
+
+void SimAdxl343_advance(uint64_t toUs)
+{
+	while (isMeasuring() && nextSampleUs <= toUs) {
+		nowUs = nextSampleUs;
+		sample();
+		nextSampleUs += samplePeriodUs();
+	}
+	nowUs = toUs;
+}
+
+uint64_t SimAdxl343_getSampleCount()
+{
+	return numSamples;
+}
+
+uint64_t SimAdxl343_getLostCount()
+{
+	return numLost;
+}
+
+uint64_t SimAdxl343_getNextSampleUs()
+{
+	return isMeasuring() ? nextSampleUs : UINT64_MAX;
+}
+
+// Sources mapped to 0 in INT_MAP go to INT1
+bool SimAdxl343_getInt1()
+{
+	return regs[REG_INT_SOURCE] & regs[REG_INT_ENABLE] & ~regs[REG_INT_MAP];
+}
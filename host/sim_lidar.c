@@ -0,0 +1,317 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - sim_lidar.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains a model of a TF-series LIDAR streaming 9 byte
+/	0x59 0x59 frames at a fixed rate over a 115200 baud UART.
+/	A share of the frames can be made bad, alternately a weak return
+/	and a strong return off something closer, like a branch or rain.
+/	It answers the 0x5A configuration commands the firmware sends: frame
+/	rate and output format are echoed back, save settings answers with a
+/	status byte. Like the sensor, an answer goes out a millisecond after
+/	the command, between two frames.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include "sim.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define BAUD_RATE 115200
+#define BYTE_NS (10ULL * 1000000000ULL / BAUD_RATE) // 8N1
+#define FRAME_SIZE 9
+
+#define DEFAULT_RATE_HZ 100
+#define MAX_RATE_HZ 1000
+#define DEFAULT_STRENGTH 1200
+#define WEAK_STRENGTH 40
+#define TEMP_RAW ((25 + 256) * 8) // 25 C
+
+#define CMD_HEADER 0x5A
+#define CMD_MAX_LEN 16
+#define CMD_FRAME_RATE 0x03
+#define CMD_OUTPUT_FORMAT 0x05
+#define CMD_SAVE 0x11
+#define FORMAT_CM 0x01
+#define FORMAT_MM 0x06
+#define RESPONSE_NS 1000000ULL
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static int distanceCm = 10000;
+static int rangeRateCms = 0;			// Added to distanceCm per second
+static int strength = DEFAULT_STRENGTH;
+static int rateHz = DEFAULT_RATE_HZ;
+static bool isConnected = true;
+static bool isStreaming = true;
+static bool isMm = false;
+static int badPercent = 0;
+static uint32_t badState = 1;
+static bool isBadWeak = false;
+
+static uint8_t frame[CMD_MAX_LEN];		// A frame or an answer
+static int frameLen = FRAME_SIZE;
+static int frameIndex = FRAME_SIZE;		// frameLen when idle
+static uint64_t nextFrameNs = 0;
+static uint64_t nextByteNs = 0;
+
+static uint8_t command[CMD_MAX_LEN];
+static int commandIndex = 0;
+static uint64_t numCommands = 0;
+
+static uint8_t response[CMD_MAX_LEN];
+static int responseLen = 0;				// 0 when nothing to answer
+static uint64_t responseNs = 0;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static bool isBadFrame()
+{
+	badState = badState * 1103515245 + 12345;
+	return (int)((badState >> 16) % 100) < badPercent;
+}
+
+static void buildFrame(uint64_t atNs)
+{
+	int checksum = 0;
+	int frameDistance = distanceCm + (int)((int64_t)rangeRateCms * (int64_t)atNs / 1000000000);
+	int frameStrength = strength;
+
+	if (frameDistance < 1)
+		frameDistance = 1;
+
+	if (isBadFrame()) {
+		isBadWeak = !isBadWeak;
+		if (isBadWeak) {
+			frameStrength = WEAK_STRENGTH;
+			frameDistance *= 2;
+		} else {
+			frameDistance /= 3;
+		}
+	}
+
+	if (isMm) {
+		frameDistance *= 10;
+		if (frameDistance > 65535)
+			frameDistance = 65535;
+	}
+
+	frame[0] = 0x59;
+	frame[1] = 0x59;
+	frame[2] = frameDistance & 0xFF;
+	frame[3] = (frameDistance >> 8) & 0xFF;
+	frame[4] = frameStrength & 0xFF;
+	frame[5] = (frameStrength >> 8) & 0xFF;
+	frame[6] = TEMP_RAW & 0xFF;
+	frame[7] = (TEMP_RAW >> 8) & 0xFF;
+
+	for (int i = 0; i < FRAME_SIZE - 1; i++) {
+		checksum += frame[i];
+	}
+	frame[8] = checksum & 0xFF;
+}
+
+static uint8_t checksum(const uint8_t bytes[], int len)
+{
+	int sum = 0;
+
+	for (int i = 0; i < len; i++) {
+		sum += bytes[i];
+	}
+	return sum & 0xFF;
+}
+
+static void answer(const uint8_t bytes[], int len, uint64_t atNs)
+{
+	for (int i = 0; i < len; i++) {
+		response[i] = bytes[i];
+	}
+	responseLen = len;
+	responseNs = atNs + RESPONSE_NS;
+}
+
+// Acts on a complete command with a good checksum, received at doneNs
+static void runCommand(int len, uint64_t doneNs)
+{
+	uint8_t saved[] = {CMD_HEADER, 0x05, CMD_SAVE, 0x00, 0x00};
+	int rate;
+
+	switch (command[2]) {
+	case CMD_FRAME_RATE:
+		rate = command[3] | command[4] << 8;
+		if (len != 6 || rate <= 0 || rate > MAX_RATE_HZ) {
+			return;
+		}
+		rateHz = rate;
+		nextFrameNs = doneNs + RESPONSE_NS + 1000000000ULL / rateHz;
+		break;
+	case CMD_OUTPUT_FORMAT:
+		if (len != 5 || (command[3] != FORMAT_CM && command[3] != FORMAT_MM)) {
+			return;
+		}
+		isMm = command[3] == FORMAT_MM;
+		break;
+	case CMD_SAVE:
+		saved[4] = checksum(saved, 4);
+		answer(saved, sizeof(saved), doneNs);
+		numCommands++;
+		return;
+	default:
+		return;
+	}
+
+	answer(command, len, doneNs);
+	numCommands++;
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void SimLidar_reset()
+{
+	distanceCm = 10000;
+	rangeRateCms = 0;
+	strength = DEFAULT_STRENGTH;
+	rateHz = DEFAULT_RATE_HZ;
+	isConnected = true;
+	isStreaming = true;
+	isMm = false;
+	badPercent = 0;
+	badState = 1;
+	isBadWeak = false;
+	frameLen = FRAME_SIZE;
+	frameIndex = FRAME_SIZE;
+	nextFrameNs = 0;
+	nextByteNs = 0;
+	commandIndex = 0;
+	numCommands = 0;
+	responseLen = 0;
+}
+
+void SimLidar_setDistanceCm(int distance_cm)
+{
+	distanceCm = distance_cm;
+}
+
+void SimLidar_setRangeRate(int cmPerS)
+{
+	rangeRateCms = cmPerS;
+}
+
+void SimLidar_setStrength(int value)
+{
+	strength = value;
+}
+
+void SimLidar_setRateHz(int value)
+{
+	rateHz = value;
+	isConnected = value > 0;
+}
+
+int SimLidar_getRateHz()
+{
+	return isConnected ? rateHz : 0;
+}
+
+uint64_t SimLidar_getCommandCount()
+{
+	return numCommands;
+}
+
+// Takes the bytes the firmware sent from atUs on, one byte time apart
+void SimLidar_receive(const uint8_t *data, size_t len, uint64_t atUs)
+{
+	uint64_t byteNs = atUs * 1000;
+
+	if (!isConnected) {
+		return;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		uint8_t byte = data[i];
+		byteNs += BYTE_NS;
+
+		if (commandIndex == 0 && byte != CMD_HEADER) {
+			continue;
+		}
+		command[commandIndex++] = byte;
+
+		int commandLen = commandIndex > 1 ? command[1] : CMD_MAX_LEN;
+		if (commandLen < 4 || commandLen > CMD_MAX_LEN) {
+			commandIndex = 0;
+		} else if (commandIndex == commandLen) {
+			commandIndex = 0;
+			if (checksum(command, commandLen - 1) == command[commandLen - 1]) {
+				runCommand(commandLen, byteNs);
+			}
+		}
+	}
+}
+
+void SimLidar_setStreaming(bool streaming)
+{
+	isStreaming = streaming;
+}
+
+void SimLidar_setBadPercent(int percent)
+{
+	badPercent = percent;
+}
+
+// Puts every byte due by toUs on the wire, in order
+void SimLidar_advance(uint64_t toUs, void (*rx)(uint8_t byte))
+{
+	uint64_t toNs = toUs * 1000;
+
+	while (true) {
+		if (frameIndex >= frameLen) {
+			uint64_t startNs;
+
+			// An answer goes out ahead of the frames due after it
+			if (responseLen > 0 && (responseNs <= nextFrameNs || !isStreaming)) {
+				if (responseNs > toNs) {
+					return;
+				}
+				for (int i = 0; i < responseLen; i++) {
+					frame[i] = response[i];
+				}
+				frameLen = responseLen;
+				responseLen = 0;
+				startNs = responseNs;
+			} else {
+				if (!isConnected || !isStreaming || nextFrameNs > toNs) {
+					return;
+				}
+				buildFrame(nextFrameNs);
+				frameLen = FRAME_SIZE;
+				startNs = nextFrameNs;
+				nextFrameNs += 1000000000ULL / rateHz;
+			}
+
+			frameIndex = 0;
+			if (nextByteNs < startNs)
+				nextByteNs = startNs;
+		}
+
+		if (nextByteNs > toNs) {
+			return;
+		}
+
+		rx(frame[frameIndex++]);
+		nextByteNs += BYTE_NS;
+	}
+}
@@ -0,0 +1,177 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - sim_oled.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains a model of the SSD1306-style 128x64 OLED controller
+/	in 4-wire SPI mode. Only the commands the driver uses are decoded, the
+/	rest are accepted and ignored.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <string.h>
+#include "sim.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define NUM_PAGES 8
+#define NUM_COLS 128
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static uint8_t gram[NUM_PAGES][NUM_COLS];
+
+static bool isSelected = false;
+static bool isData = false;
+
+static uint8_t colStart = 0, colEnd = NUM_COLS - 1;
+static uint8_t pageStart = 0, pageEnd = NUM_PAGES - 1;
+static uint8_t col = 0, page = 0;
+static uint8_t contrast = 0x7F;
+
+// Command being assembled
+static uint8_t cmd = 0;
+static uint8_t cmdArgs[2];
+static int cmdArgsNeeded = 0;
+static int cmdArgsReceived = 0;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static int argsFor(uint8_t command)
+{
+	switch (command) {
+	case 0x20: // Addressing mode
+	case 0x81: // Contrast
+		return 1;
+	case 0x21: // Column range
+	case 0x22: // Page range
+		return 2;
+	default:
+		return 0;
+	}
+}
+
+static void executeCommand()
+{
+	switch (cmd) {
+	case 0x21:
+		colStart = cmdArgs[0] % NUM_COLS;
+		colEnd = cmdArgs[1] % NUM_COLS;
+		col = colStart;
+		break;
+	case 0x22:
+		pageStart = cmdArgs[0] % NUM_PAGES;
+		pageEnd = cmdArgs[1] % NUM_PAGES;
+		page = pageStart;
+		break;
+	case 0x81:
+		contrast = cmdArgs[0];
+		break;
+	default:
+		break;
+	}
+}
+
+static void writeCommand(uint8_t byte)
+{
+	if (cmdArgsReceived < cmdArgsNeeded) {
+		cmdArgs[cmdArgsReceived++] = byte;
+	} else {
+		cmd = byte;
+		cmdArgsNeeded = argsFor(byte);
+		cmdArgsReceived = 0;
+	}
+
+	if (cmdArgsReceived == cmdArgsNeeded) {
+		executeCommand();
+	}
+}
+
+// Horizontal addressing mode, wraps inside the column and page window
+static void writeData(uint8_t byte)
+{
+	gram[page][col] = byte;
+
+	if (col < colEnd) {
+		col++;
+		return;
+	}
+
+	col = colStart;
+	page = page < pageEnd ? page + 1 : pageStart;
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void SimOled_reset()
+{
+	memset(gram, 0, sizeof(gram));
+	isSelected = false;
+	isData = false;
+	colStart = 0;
+	colEnd = NUM_COLS - 1;
+	pageStart = 0;
+	pageEnd = NUM_PAGES - 1;
+	col = 0;
+	page = 0;
+	contrast = 0x7F;
+	cmdArgsNeeded = 0;
+	cmdArgsReceived = 0;
+}
+
+void SimOled_gpio(uint32_t pin, bool level)
+{
+	if (pin == SIM_OLED_PIN_CS) {
+		isSelected = !level;
+	} else if (pin == SIM_OLED_PIN_DC) {
+		isData = level;
+	}
+}
+
+void SimOled_write(uint8_t byte)
+{
+	if (!isSelected) {
+		return;
+	}
+
+	if (isData) {
+		writeData(byte);
+	} else {
+		writeCommand(byte);
+	}
+}
+
+uint8_t SimOled_getColumn(int p, int c)
+{
+	return gram[p % NUM_PAGES][c % NUM_COLS];
+}
+
+uint8_t SimOled_getContrast()
+{
+	return contrast;
+}
+
+// Page 0 is drawn at the bottom, the same way the optic is viewed
+void SimOled_print(FILE *out)
+{
+	for (int row = NUM_PAGES * 8 - 1; row >= 0; row--) {
+		for (int c = 0; c < NUM_COLS; c++) {
+			bool isOn = gram[row / 8][c] & (1 << (row % 8));
+			fputc(isOn ? '#' : '.', out);
+		}
+		fputc('\n', out);
+	}
+}
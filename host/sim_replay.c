@@ -0,0 +1,311 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - sim_replay.c													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the sensor replay. It reads a capture (capture.h),
+/	a raw log of the USB serial port or IFOBS_SIM_TRACE from a run with
+/	the capture on, and plays it back in place of the simulated sensors.
+/	Text and trace records between the packets are skipped.
+/
+/	The LIDAR bytes go onto UART1 at the time they were captured, measured
+/	from the first packet, which lines up with the start of the main loop.
+/	The accelerometer samples take the place of the simulated ones in the
+/	order they were captured, one per sample the ADXL343 model takes at
+/	its own output data rate. Each keeps the time it was captured, the
+/	packet's time plus SAMPLE_PERIOD_US per sample before it. The model's
+/	first sample after the start sets how far apart the two clocks are,
+/	and when a later one is more than ALIGN_SLACK_NS off that, the replay
+/	holds or skips samples to line up again. A packet lost from the
+/	capture would otherwise pull every later sample early against the
+/	LIDAR bytes. Until the main loop starts it keeps giving the first one,
+/	so the drivers settle on the captured attitude during setup.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "capture.h"
+#include "sim.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define BAUD_RATE 115200
+#define BYTE_NS (10ULL * 1000000000ULL / BAUD_RATE) // 8N1
+
+#define ACCEL_SAMPLE_SIZE 6
+#define ACCEL_PERIOD_NS 2500000ULL	// SAMPLE_PERIOD_US in accelerometer.c
+
+// The driver dates the samples from its drain time, so they jitter a
+// little against the model, only half a sample or more off is a gap
+#define ALIGN_SLACK_NS ((int64_t)ACCEL_PERIOD_NS / 2)
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	uint64_t atNs;				// From the first packet
+	size_t offset;				// Into lidarBytes
+	int len;
+} LidarPacket;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static bool isLoaded = false;
+static bool isStarted = false;
+static uint64_t startNs;
+
+static int16_t (*accel)[3] = NULL;
+static int64_t *accelNs = NULL;		// From the first packet, can be before it
+static size_t numAccel = 0;
+static size_t accelIndex = 0;
+static bool isAligned = false;
+static int64_t alignNs;				// Model time less captured time
+
+static LidarPacket *lidarPackets = NULL;
+static size_t numLidarPackets = 0;
+static uint8_t *lidarBytes = NULL;
+static size_t numLidarBytes = 0;
+static size_t packetIndex = 0;
+static int byteIndex = 0;
+static uint64_t nextByteNs = 0;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static uint8_t *readFile(const char *path, size_t *size)
+{
+	FILE *file = fopen(path, "rb");
+	uint8_t *data = NULL;
+	size_t capacity = 0;
+
+	*size = 0;
+	if (!file) {
+		return NULL;
+	}
+
+	while (true) {
+		if (*size == capacity) {
+			capacity = capacity ? capacity * 2 : 65536;
+			data = realloc(data, capacity);
+		}
+		size_t numRead = fread(data + *size, 1, capacity - *size, file);
+		if (numRead == 0) {
+			break;
+		}
+		*size += numRead;
+	}
+
+	fclose(file);
+	return data;
+}
+
+// Length of the packet at bytes, 0 if there isn't a whole good one
+static size_t packetLen(const uint8_t bytes[], size_t left)
+{
+	uint8_t sum = 0;
+	size_t len;
+
+	if (left < CAPTURE_HEADER_SIZE + 1 || bytes[0] != CAPTURE_SYNC0
+			|| bytes[1] != CAPTURE_SYNC1) {
+		return 0;
+	}
+
+	len = CAPTURE_HEADER_SIZE + bytes[3] + 1;
+	if (bytes[3] > CAPTURE_MAX_PAYLOAD || len > left) {
+		return 0;
+	}
+
+	for (size_t i = 2; i < len; i++) {
+		sum += bytes[i];
+	}
+	return sum == 0 ? len : 0;
+}
+
+static void addAccel(const uint8_t payload[], int len, int64_t atNs)
+{
+	int count = len / ACCEL_SAMPLE_SIZE;
+
+	accel = realloc(accel, (numAccel + count) * sizeof(accel[0]));
+	accelNs = realloc(accelNs, (numAccel + count) * sizeof(accelNs[0]));
+	for (int i = 0; i < count; i++) {
+		const uint8_t *data = &payload[i * ACCEL_SAMPLE_SIZE];
+
+		for (int j = 0; j < 3; j++) {
+			accel[numAccel][j] = (int16_t)(data[2*j] | data[2*j + 1] << 8);
+		}
+		accelNs[numAccel] = atNs + i * (int64_t)ACCEL_PERIOD_NS;
+		numAccel++;
+	}
+}
+
+static void addLidar(const uint8_t payload[], int len, uint64_t atNs)
+{
+	lidarPackets = realloc(lidarPackets, (numLidarPackets + 1) * sizeof(LidarPacket));
+	lidarPackets[numLidarPackets].atNs = atNs;
+	lidarPackets[numLidarPackets].offset = numLidarBytes;
+	lidarPackets[numLidarPackets].len = len;
+	numLidarPackets++;
+
+	lidarBytes = realloc(lidarBytes, numLidarBytes + len);
+	for (int i = 0; i < len; i++) {
+		lidarBytes[numLidarBytes++] = payload[i];
+	}
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+bool SimReplay_load(const char *path)
+{
+	size_t size;
+	uint8_t *data = readFile(path, &size);
+	size_t numPackets = 0;
+	size_t numMissing = 0;
+	uint32_t firstUs = 0;
+	uint32_t lastUs = 0;
+	int nextSequence = -1;
+
+	if (!data) {
+		return false;
+	}
+
+	for (size_t i = 0; i < size; ) {
+		size_t len = packetLen(&data[i], size - i);
+
+		if (len == 0) {
+			i++;
+			continue;
+		}
+
+		const uint8_t *packet = &data[i];
+		const uint8_t *payload = &packet[CAPTURE_HEADER_SIZE];
+		uint32_t timeUs = packet[5] | packet[6] << 8 | packet[7] << 16
+				| (uint32_t)packet[8] << 24;
+
+		if (numPackets == 0) {
+			firstUs = timeUs;
+		}
+		if (nextSequence >= 0) {
+			numMissing += (packet[4] - nextSequence) & 0xFF;
+		}
+		nextSequence = (packet[4] + 1) & 0xFF;
+		numPackets++;
+
+		// Wraps after 71 minutes, so only the difference is used
+		lastUs = timeUs;
+		if (packet[2] == CAPTURE_ACCEL) {
+			// A drain can date its first sample before the packet ahead of it
+			addAccel(payload, packet[3], (int64_t)(int32_t)(timeUs - firstUs) * 1000);
+		} else if (packet[2] == CAPTURE_LIDAR) {
+			addLidar(payload, packet[3], (uint64_t)(timeUs - firstUs) * 1000);
+		}
+		i += len;
+	}
+	free(data);
+
+	fprintf(stderr, "replay: %zu packets over %.1f s, %zu accel samples, "
+			"%zu lidar bytes\n", numPackets, (uint32_t)(lastUs - firstUs) / 1e6,
+			numAccel, numLidarBytes);
+	if (numMissing > 0) {
+		fprintf(stderr, "replay: %zu packets missing from the capture\n", numMissing);
+	}
+
+	isLoaded = numPackets > 0;
+	return isLoaded;
+}
+
+void SimReplay_start(uint64_t atUs)
+{
+	isStarted = isLoaded;
+	startNs = atUs * 1000;
+}
+
+bool SimReplay_getAccel(uint64_t atUs, int16_t value[3])
+{
+	size_t index = accelIndex;
+
+	if (numAccel == 0) {
+		return false;
+	}
+
+	// Holds the first sample until the start, and the last one at the end
+	if (isStarted && accelIndex < numAccel) {
+		int64_t atNs = (int64_t)(atUs * 1000) - (int64_t)startNs;
+
+		// The model's first sample takes the last one captured by then,
+		// and the rest keep the same distance from their captured times
+		if (!isAligned) {
+			while (accelIndex + 1 < numAccel && accelNs[accelIndex + 1] <= atNs) {
+				accelIndex++;
+			}
+			alignNs = atNs - accelNs[accelIndex];
+			isAligned = true;
+		}
+
+		// Skips the samples the model has fallen behind, then holds the
+		// last one played while the next is still ahead of it
+		while (accelIndex + 1 < numAccel
+				&& accelNs[accelIndex] + alignNs + ALIGN_SLACK_NS < atNs) {
+			accelIndex++;
+		}
+		index = accelIndex;
+		if (accelNs[accelIndex] + alignNs > atNs + ALIGN_SLACK_NS && accelIndex > 0) {
+			index = accelIndex - 1;
+		} else {
+			accelIndex++;
+		}
+	}
+	if (index >= numAccel) {
+		index = numAccel - 1;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		value[i] = accel[index][i];
+	}
+	return true;
+}
+
+// Puts every byte due by toUs on the wire, in order
+void SimReplay_advance(uint64_t toUs, void (*rx)(uint8_t byte))
+{
+	uint64_t toNs = toUs * 1000;
+
+	if (!isStarted) {
+		return;
+	}
+
+	while (packetIndex < numLidarPackets) {
+		const LidarPacket *packet = &lidarPackets[packetIndex];
+
+		if (byteIndex == 0 && nextByteNs < startNs + packet->atNs)
+			nextByteNs = startNs + packet->atNs;
+		if (nextByteNs > toNs) {
+			return;
+		}
+
+		rx(lidarBytes[packet->offset + byteIndex]);
+		nextByteNs += BYTE_NS;
+
+		if (++byteIndex == packet->len) {
+			byteIndex = 0;
+			packetIndex++;
+		}
+	}
+}
+
+bool SimReplay_isDone()
+{
+	return isStarted && packetIndex == numLidarPackets && accelIndex == numAccel;
+}
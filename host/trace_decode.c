@@ -0,0 +1,151 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - trace_decode.c													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the decoder for the binary trace (trace.h). It reads
+/	a capture of the USB serial port, or IFOBS_SIM_TRACE from a simulation
+/	run, and writes one CSV line per record to stdout. Text printed between
+/	the records is skipped. A summary of the records, bad checksums and
+/	records lost on the way goes to stderr.
+/
+/	Usage: ifobs_trace_decode [capture]		(stdin without one)
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "trace.h"
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static unsigned long numRecords = 0;
+static unsigned long numBadChecksums = 0;
+static unsigned long numDropped = 0;	// By the firmware, the queue was full
+static unsigned long numLost = 0;		// Sequence gaps the drops don't explain
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static bool isValid(const uint8_t bytes[])
+{
+	uint8_t sum = 0;
+
+	for (int i = 2; i < TRACE_RECORD_SIZE; i++) {
+		sum += bytes[i];
+	}
+	return sum == 0;
+}
+
+// Drops the bytes before the next place a record could start
+// Returns how many are left
+static int resync(uint8_t bytes[], int count)
+{
+	int from = 1;
+
+	while (from < count && (bytes[from] != TRACE_SYNC0
+			|| (from + 1 < count && bytes[from + 1] != TRACE_SYNC1))) {
+		from++;
+	}
+	memmove(bytes, bytes + from, (size_t)(count - from));
+	return count - from;
+}
+
+static void printHeader()
+{
+	printf("time_us,sample_us,accel_x,accel_y,accel_z,distance_cm,raw_cm,strength,"
+			"confidence,elev_deg,cant_deg,x_px,z_px,accel_us,lidar_us,"
+			"ballistics_us,display_us,locked,dropped\n");
+}
+
+static void printRecord(const TraceRecord *record)
+{
+	printf("%lu,%lu,%d,%d,%d,%d,%d,%u,%u,%.2f,%.2f,%d,%d,%u,%u,%u,%u,%d,%u\n",
+			(unsigned long)record->timeUs, (unsigned long)record->sampleUs,
+			record->accel[0], record->accel[1], record->accel[2],
+			record->distance_cm, record->rawDistance_cm, record->strength,
+			record->confidence, record->elev_cdeg / 100.0, record->cant_cdeg / 100.0,
+			record->xOffset, record->zOffset,
+			record->stageUs[TRACE_STAGE_ACCEL], record->stageUs[TRACE_STAGE_LIDAR],
+			record->stageUs[TRACE_STAGE_BALLISTICS], record->stageUs[TRACE_STAGE_DISPLAY],
+			(record->flags & TRACE_FLAG_LOCKED) ? 1 : 0, record->numDropped);
+}
+
+static void decode(FILE *in)
+{
+	uint8_t bytes[TRACE_RECORD_SIZE];
+	int count = 0;
+	int nextSequence = -1;
+	int c;
+
+	while ((c = fgetc(in)) != EOF) {
+		bytes[count++] = (uint8_t)c;
+
+		// Text, or the sync bytes don't line up yet
+		if (count <= 2 && (bytes[0] != TRACE_SYNC0
+				|| (count == 2 && bytes[1] != TRACE_SYNC1))) {
+			count = resync(bytes, count);
+			continue;
+		}
+		if (count < TRACE_RECORD_SIZE) {
+			continue;
+		}
+
+		// Sync bytes that happened to be in a record, or a damaged one
+		if (!isValid(bytes)) {
+			numBadChecksums++;
+			count = resync(bytes, count);
+			continue;
+		}
+		count = 0;
+
+		TraceRecord record;
+		memcpy(&record, bytes, sizeof(record));
+
+		if (nextSequence >= 0) {
+			int gap = (record.sequence - nextSequence) & 0xFF;
+			numLost += gap > record.numDropped ? gap - record.numDropped : 0;
+		}
+		nextSequence = (record.sequence + 1) & 0xFF;
+		numDropped += record.numDropped;
+		numRecords++;
+
+		printRecord(&record);
+	}
+}
+
+/*--------------------------------------------------------------*/
+/* Main Function												*/
+/*--------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+
+	if (argc > 1) {
+		in = fopen(argv[1], "rb");
+		if (!in) {
+			fprintf(stderr, "can't open %s\n", argv[1]);
+			return 1;
+		}
+	}
+
+	printHeader();
+	decode(in);
+
+	fprintf(stderr, "%lu records, %lu bad checksums, %lu dropped by the firmware, "
+			"%lu lost\n", numRecords, numBadChecksums, numDropped, numLost);
+
+	if (in != stdin) {
+		fclose(in);
+	}
+	return 0;
+}
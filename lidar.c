@@ -4,9 +4,26 @@
 /	Mint Luc
 /	Bowie Gian
 /	Created: 2023-06-30
-/	Modified: 2023-07-28
+/	Modified: 2026-10-17
 /
 /	This file contains the functions that will setup and poll the LIDAR.
+/
+/	The UART1 RX interrupt copies every byte into rxRing with the time it
+/	was received. The ring has a single producer (the interrupt) and a
+/	single consumer (Lidar_distancePoll), so it needs no locking: only the
+/	interrupt writes rxHead and only the poll writes rxTail. The poll runs
+/	the 9 byte 0x59 0x59 frame parser over whatever has arrived since the
+/	last call, and every frame goes through the range filter
+/	(rangefilter.c) before Lidar_getDistanceCm() sees it. With the capture
+/	on (capture.c) the poll copies every byte out as it parses it.
+/
+/	At setup the sensor is put in the standard (cm) output format at
+/	RATE_HZ and the settings are saved, so it comes back the same after a
+/	power cycle. Each command is a 0x5A frame that the sensor answers
+/	between two data frames, which the poll picks out of the same stream.
+/	A command without an answer is sent again after ACK_TIMEOUT_US. While
+/	the range is locked the distance isn't used, so the sensor drops to
+/	LOCKED_RATE_HZ to save power, that change isn't saved.
 / ----------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------*/
@@ -14,11 +31,14 @@
 /*--------------------------------------------------------------*/
 
 #include <stdio.h>
-#include "pico/stdlib.h"
-#include "hardware/gpio.h"
+#ifndef IFOBS_HOST
 #include "pico/binary_info.h"
-#include "hardware/uart.h"
+#endif
+#include "capture.h"
+#include "hal.h"
 #include "lidar.h"
+#include "rangefilter.h"
+#include "trace.h"
 
 /*--------------------------------------------------------------*/
 /* Definitions													*/
@@ -27,7 +47,7 @@
 // which port we want to use uart0 or uart1
 // #define UART_ID0 uart0
 #define BAUD_RATE 115200
-#define UART_ID1 uart1
+#define UART_ID1 HAL_UART1
 
 // We are using pins 0 and 1 for uart0 and pins 11 and 12 for uart1, but see the GPIO function select table in the
 // datasheet for information on which other pins can be used.
@@ -38,9 +58,35 @@
 #define PIN_BUTTON 11
 #define PIN_5V_REG 16
 
-// The Lidar will sometimes not respond to a poll
-// This is the amount of polls that can be missed before returning disconnected
-#define MAX_POLLS_MISSED 1
+// The Lidar will sometimes skip a frame
+// This is how long it can go without a valid frame before returning disconnected
+#define FRAME_TIMEOUT_US 200000
+
+#define FRAME_LEN 9
+
+// TF-series commands are 0x5A, length, id, data, checksum
+#define CMD_HEADER 0x5A
+#define CMD_MAX_LEN 8
+#define CMD_FRAME_RATE 0x03
+#define CMD_OUTPUT_FORMAT 0x05
+#define CMD_SAVE 0x11
+#define FORMAT_CM 0x01
+
+#define ACK_TIMEOUT_US 100000
+#define ACK_RETRIES 2
+
+// The fastest rate every TF-series model has (TF-Luna tops out at 250 Hz),
+// 2250 bytes/s or a fifth of the line, the range filter's 5 frame window
+// spans 20 ms at it
+#define RATE_HZ 250
+
+// Keeps a few frames inside FRAME_TIMEOUT_US so a locked sensor doesn't
+// look disconnected
+#define LOCKED_RATE_HZ 20
+
+// Holds 175 ms of bytes at the full 115200 baud line rate, must be a power of 2
+#define RX_RING_SIZE 2048
+#define RX_RING_MASK (RX_RING_SIZE - 1)
 
 /*--------------------------------------------------------------*/
 /* Global Variables				 								*/
@@ -49,7 +95,34 @@
 static bool ret;
 static bool isLocked = false;
 static bool prevButtonState = false;
-static int numPollsMissed = 0;
+
+// Written by the RX interrupt only
+static uint8_t rxRing[RX_RING_SIZE];
+static uint32_t rxTime[RX_RING_SIZE];
+static volatile uint32_t rxHead = 0;
+static volatile uint32_t rxOverflows = 0;
+static void (*frameCallback)(void) = NULL;
+
+// Written by Lidar_distancePoll only
+static volatile uint32_t rxTail = 0;
+static uint32_t lastOverflows = 0;
+static bool isConnected = false;
+
+static LidarFrame lastFrame = {LIDAR_DC, 0, 0};
+static uint32_t numFrames = 0;
+static RangeFilter rangeFilter;
+
+// The command waiting for its answer, none when commandLen is 0
+static uint8_t command[CMD_MAX_LEN];
+static int commandLen = 0;
+static uint32_t commandUs;
+static int numRetries;
+static bool isCommandOk = false;
+static uint8_t response[CMD_MAX_LEN];
+static int responseIndex = 0;
+
+// The last rate the sensor took, 0 if unknown
+static int rateHz = 0;
 
 //************************Structure and Union for handling LiDAR Data***********
 
@@ -77,55 +150,242 @@ union unionLidar Lidar;
 // Setup distance lock button and 5V step up
 static void setupGPIO()
 {
-	gpio_init(PIN_BUTTON);
-	gpio_set_dir(PIN_BUTTON, GPIO_IN);
-	gpio_pull_up(PIN_BUTTON);
+	Hal_gpioInit(PIN_BUTTON);
+	Hal_gpioSetDir(PIN_BUTTON, HAL_GPIO_IN);
+	Hal_gpioPullUp(PIN_BUTTON);
+
+	Hal_gpioInit(PIN_5V_REG);
+	Hal_gpioSetDir(PIN_5V_REG, HAL_GPIO_OUT);
+	Hal_gpioPut(PIN_5V_REG, 1);
+}
+
+// UART1 RX interrupt, moves the hardware FIFO into rxRing
+static void onUartRx()
+{
+	uint32_t timeUs = (uint32_t)Hal_timeUs();
+
+	while (Hal_uartIsReadable(UART_ID1)) {
+		uint8_t byte = Hal_uartGetc(UART_ID1);
+		uint32_t head = rxHead;
+		uint32_t next = (head + 1) & RX_RING_MASK;
 
-	gpio_init(PIN_5V_REG);
-	gpio_set_dir(PIN_5V_REG, GPIO_OUT);
-	gpio_put(PIN_5V_REG, 1);
+		if (next == __atomic_load_n(&rxTail, __ATOMIC_ACQUIRE)) {
+			rxOverflows++;
+			continue;
+		}
+
+		rxRing[head] = byte;
+		rxTime[head] = timeUs;
+		__atomic_store_n(&rxHead, next, __ATOMIC_RELEASE);
+	}
+
+	// Any FRAME_LEN bytes in a row contain the end of a frame
+	uint32_t waiting = (rxHead - __atomic_load_n(&rxTail, __ATOMIC_ACQUIRE)) & RX_RING_MASK;
+	if (frameCallback && waiting >= FRAME_LEN) {
+		frameCallback();
+	}
 }
 
-// Function to read serial data
-static int isLidar(uart_inst_t * uart, union unionLidar * lidar)
+// Feeds one byte to the frame parser
+// Returns 1 when the byte completes a frame with a good checksum
+static int isLidar(unsigned char serialChar, union unionLidar * lidar)
 {
 	int loop;
 	int checksum;
-	unsigned char serialChar;
 
-	while (uart_is_readable(uart)) {
-		if (lidarCounter > 8) {
+	if (lidarCounter > 8) {
+		lidarCounter=0;
+		return 0; // something wrong
+	}
+
+	lidar->Byte[lidarCounter] = serialChar;
+
+	switch (lidarCounter++)
+	{
+	case 0:
+	case 1:
+		if (serialChar !=0x59)
 			lidarCounter=0;
-			return 0; // something wrong
+		break;
+	case 8: // checksum
+		checksum = 0;
+		lidarCounter = 0;
+
+		for (loop=0;loop<8;loop++)
+			checksum+= lidar->Byte[loop];
+
+		if ((checksum &0xff) == serialChar) {
+			//printf("checksum ok\n");
+			lidar->lidar.Dist = lidar->Byte[2] | lidar->Byte[3] << 8;
+			lidar->lidar.Strength = lidar->Byte[4] | lidar->Byte[5] << 8;
+			return 1;
+		}
+		//printf("bad checksum %02x != %02x\n",checksum & 0xff, serialChar);
+	}
+	return 0;
+}
+
+static void sendCommand(uint8_t id, const uint8_t data[], int len)
+{
+	int checksum = 0;
+
+	command[0] = CMD_HEADER;
+	command[1] = (uint8_t)(len + 4);
+	command[2] = id;
+	for (int i = 0; i < len; i++) {
+		command[3 + i] = data[i];
+	}
+	for (int i = 0; i < len + 3; i++) {
+		checksum += command[i];
+	}
+	command[len + 3] = checksum & 0xFF;
+
+	commandLen = len + 4;
+	commandUs = (uint32_t)Hal_timeUs();
+	numRetries = 0;
+	Hal_uartWrite(UART_ID1, command, (size_t)commandLen);
+}
+
+static void setRate(int hz)
+{
+	uint8_t data[] = {hz & 0xFF, (hz >> 8) & 0xFF};
+
+	sendCommand(CMD_FRAME_RATE, data, sizeof(data));
+}
+
+static void onCommandDone(bool isOk)
+{
+	commandLen = 0;
+	isCommandOk = isOk;
+
+	if (!isOk) {
+		printf("LIDAR didn't take command 0x%02X\n", command[2]);
+	} else if (command[2] == CMD_FRAME_RATE) {
+		rateHz = command[3] | command[4] << 8;
+		printf("LIDAR at %d Hz\n", rateHz);
+	}
+}
+
+// Feeds one byte to the command answer parser
+// Rate and format commands are echoed back, save answers with a status
+static void parseResponse(uint8_t byte)
+{
+	if (responseIndex == 0 && byte != CMD_HEADER) {
+		return;
+	}
+	response[responseIndex++] = byte;
+
+	int len = responseIndex > 1 ? response[1] : CMD_MAX_LEN;
+	if (len < 4 || len > CMD_MAX_LEN) {
+		responseIndex = 0;
+		return;
+	}
+	if (responseIndex < len) {
+		return;
+	}
+	responseIndex = 0;
+
+	int checksum = 0;
+	for (int i = 0; i < len - 1; i++) {
+		checksum += response[i];
+	}
+	if ((checksum & 0xFF) != response[len - 1] || response[2] != command[2]) {
+		return;
+	}
+
+	if (command[2] == CMD_SAVE) {
+		onCommandDone(len == 5 && response[3] == 0);
+		return;
+	}
+
+	// An echo of an earlier command is ignored
+	if (len != commandLen) {
+		return;
+	}
+	for (int i = 0; i < len; i++) {
+		if (response[i] != command[i]) {
+			return;
+		}
+	}
+	onCommandDone(true);
+}
+
+static void checkCommand()
+{
+	if (commandLen == 0 || (uint32_t)Hal_timeUs() - commandUs < ACK_TIMEOUT_US) {
+		return;
+	}
+
+	if (numRetries >= ACK_RETRIES) {
+		onCommandDone(false);
+		return;
+	}
+
+	numRetries++;
+	commandUs = (uint32_t)Hal_timeUs();
+	Hal_uartWrite(UART_ID1, command, (size_t)commandLen);
+}
+
+// Parses everything received since the last call
+// Returns true if there was a new frame
+static bool receive()
+{
+	uint32_t head = __atomic_load_n(&rxHead, __ATOMIC_ACQUIRE);
+	uint32_t tail = rxTail;
+	bool isNewFrame = false;
+
+	while (tail != head) {
+		Capture_lidarByte(rxRing[tail], rxTime[tail]);
+
+		if (commandLen > 0) {
+			parseResponse(rxRing[tail]);
 		}
 
-		serialChar = uart_getc(uart); // Read a single character to UART.
-		lidar->Byte[lidarCounter] = serialChar;
-
-		switch (lidarCounter++)
-		{
-		case 0:
-		case 1:
-			if (serialChar !=0x59)
-				lidarCounter=0;
-			break;
-		case 8: // checksum
-			checksum = 0;
-			lidarCounter = 0;
-
-			for (loop=0;loop<8;loop++)
-				checksum+= lidar->Byte[loop];
-
-			if ((checksum &0xff) == serialChar) {
-				//printf("checksum ok\n");
-				lidar->lidar.Dist = lidar->Byte[2] | lidar->Byte[3] << 8;
-				lidar->lidar.Strength = lidar->Byte[4] | lidar->Byte[5] << 8;
-				return 1;
-			}
-			//printf("bad checksum %02x != %02x\n",checksum & 0xff, serialChar);
+		if (isLidar(rxRing[tail], &Lidar)) {
+			lastFrame.distance_cm = Lidar.lidar.Dist;
+			lastFrame.strength = Lidar.lidar.Strength;
+			lastFrame.timeUs = rxTime[tail];
+			numFrames++;
+			isNewFrame = true;
+			RangeFilter_addFrame(&rangeFilter, lastFrame.distance_cm, lastFrame.strength,
+					lastFrame.timeUs);
+
+			// An answer never starts inside a frame
+			responseIndex = 0;
 		}
+		tail = (tail + 1) & RX_RING_MASK;
+	}
+	__atomic_store_n(&rxTail, tail, __ATOMIC_RELEASE);
+	Capture_flush();
+
+	checkCommand();
+	return isNewFrame;
+}
+
+// Sends a command and waits for the answer, only before the tasks start
+static bool sendCommandWait(uint8_t id, const uint8_t data[], int len)
+{
+	sendCommand(id, data, len);
+	while (commandLen > 0) {
+		Hal_sleepMs(1);
+		receive();
+	}
+	return isCommandOk;
+}
+
+// Standard output format at RATE_HZ, saved in the sensor
+static void configure()
+{
+	uint8_t format[] = {FORMAT_CM};
+	uint8_t rate[] = {RATE_HZ & 0xFF, (RATE_HZ >> 8) & 0xFF};
+
+	// Nothing more to try if it doesn't answer at all
+	if (!sendCommandWait(CMD_OUTPUT_FORMAT, format, sizeof(format))) {
+		return;
+	}
+	if (sendCommandWait(CMD_FRAME_RATE, rate, sizeof(rate))) {
+		sendCommandWait(CMD_SAVE, NULL, 0);
 	}
-	return 0;
 }
 
 /*--------------------------------------------------------------*/
@@ -142,9 +402,10 @@ void Lidar_setup()
 	// bi_decl(bi_program_description("This is a program to read from UART!"));
 	// bi_decl(bi_1pin_with_name(LED_PIN, "On-board LED"));
 	// add binary info for uart0 and uart1
-	
+#ifndef IFOBS_HOST
 	bi_decl(bi_1pin_with_name(UART1_TX_PIN, "pin-5 for uart1 TX"));
 	bi_decl(bi_1pin_with_name(UART1_RX_PIN, "pin-6 for uart1 RX"));
+#endif
 	//******************************************************************
 
 	// gpio_init(LED_PIN); // initialize pin-25
@@ -152,31 +413,40 @@ void Lidar_setup()
 
 	// Set up our UARTs with the required speed.
 	// uart_init(UART_ID0, BAUD_RATE);
-	uart_init(UART_ID1, BAUD_RATE);
+	Hal_uartInit(UART_ID1, BAUD_RATE);
 
 	// Set the TX and RX pins by using the function
 	// Look at the datasheet for more information on function select
 
-	gpio_set_function(UART1_TX_PIN, GPIO_FUNC_UART);
-	gpio_set_function(UART1_RX_PIN, GPIO_FUNC_UART);
+	Hal_gpioSetFunction(UART1_TX_PIN, HAL_GPIO_FUNC_UART);
+	Hal_gpioSetFunction(UART1_RX_PIN, HAL_GPIO_FUNC_UART);
+
+	RangeFilter_init(&rangeFilter);
+
+	// Receive in the background from now on
+	Hal_uartSetRxIrq(UART_ID1, onUartRx);
 
 	// In a default system, printf will also output via the default UART
-	sleep_ms(200);
-	ret = uart_is_enabled(uart1); // pass UART_ID1 or uart1 both are okay
+	Hal_sleepMs(200);
+	ret = Hal_uartIsEnabled(UART_ID1);
 		if(ret == true) {
 			printf("UART-1 is enabled\n");
 		}
+	configure();
 	printf("Ready to read data\n");
 }
 
 void Lidar_buttonPoll()
 {
-	bool currButtonState = !gpio_get(PIN_BUTTON);
+	bool currButtonState = !Hal_gpioGet(PIN_BUTTON);
 	if (currButtonState == prevButtonState) {
 		return;
 	} else if (currButtonState) {
 		isLocked = !isLocked;
 		prevButtonState = currButtonState;
+		if (isConnected) {
+			setRate(isLocked ? LOCKED_RATE_HZ : RATE_HZ);
+		}
 	} else {
 		prevButtonState = currButtonState;
 	}
@@ -184,29 +454,70 @@ void Lidar_buttonPoll()
 
 void Lidar_distancePoll()
 {
-	if (isLidar(UART_ID1,&Lidar)) {
-		printf("Dist: %ucm \n", Lidar.lidar.Dist);
-		numPollsMissed = 0;
-		return;
+	bool isNewFrame = receive();
+
+	if (rxOverflows != lastOverflows) {
+		printf("LIDAR rx ring overflow %u\n", (unsigned)(rxOverflows - lastOverflows));
+		lastOverflows = rxOverflows;
 	}
 
-	numPollsMissed++;
+	if (isNewFrame) {
+		// Back from a power cycle at the saved rate, or connected after setup
+		if (rateHz == 0 && commandLen == 0 && !isConnected) {
+			setRate(isLocked ? LOCKED_RATE_HZ : RATE_HZ);
+		}
+#if TRACE == 0
+		Range range = RangeFilter_get(&rangeFilter);
+		printf("Dist: %dcm (raw %dcm, %u%%)\n", range.distance_cm,
+				lastFrame.distance_cm, (unsigned)range.confidence);
+#endif
+		isConnected = true;
+		return;
+	}
 
-	if (numPollsMissed <= MAX_POLLS_MISSED) {
-		printf("LIDAR missed %d poll\n", numPollsMissed);
+	if ((uint32_t)Hal_timeUs() - lastFrame.timeUs <= FRAME_TIMEOUT_US && isConnected) {
 		return;
 	}
 
-	printf("LIDAR disconnected\r\n");
+	if (isConnected) {
+		printf("LIDAR disconnected\r\n");
+		rateHz = 0;
+	}
+	isConnected = false;
 	Lidar.lidar.Dist = LIDAR_DC;
+	RangeFilter_init(&rangeFilter);
 }
 
 short Lidar_getDistanceCm()
 {
-	return Lidar.lidar.Dist;
+	Range range = RangeFilter_get(&rangeFilter);
+
+	return isConnected && range.confidence > 0 ? range.distance_cm : LIDAR_DC;
+}
+
+Range Lidar_getRange()
+{
+	Range range = {LIDAR_DC, 0, 0};
+
+	return isConnected ? RangeFilter_get(&rangeFilter) : range;
+}
+
+LidarFrame Lidar_getFrame()
+{
+	return lastFrame;
+}
+
+uint32_t Lidar_getFrameCount()
+{
+	return numFrames;
 }
 
 bool Lidar_isLocked()
 {
 	return isLocked;
 }
+
+void Lidar_setFrameCallback(void (*callback)(void))
+{
+	frameCallback = callback;
+}
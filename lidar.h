@@ -4,13 +4,17 @@
 /	Mint Luc
 /	Bowie Gian
 /	Created: 2023-06-30
-/	Modified: 2023-07-28
+/	Modified: 2026-10-17
 /
 /	This file contains the function declarations for operating the LIDAR.
 / ----------------------------------------------------------------------------*/
 #ifndef LIDAR_H
 #define LIDAR_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "rangefilter.h"
+
 /*--------------------------------------------------------------*/
 /* Definitions													*/
 /*--------------------------------------------------------------*/
@@ -18,6 +22,16 @@
 #define LIDAR_DC -1
 #define LIDAR_MAX_CM 18000
 
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	short distance_cm;
+	unsigned short strength;
+	uint32_t timeUs;		// When the checksum byte was received
+} LidarFrame;
+
 /*--------------------------------------------------------------*/
 /* Function Prototypes	    									*/
 /*--------------------------------------------------------------*/
@@ -28,14 +42,28 @@ void Lidar_setup();
 // Toggles the LIDAR lock state
 void Lidar_buttonPoll();
 
-// Polls the LIDAR, the distance is returned from Lidar_getDistanceCm()
+// Parses the frames received since the last poll, never blocks
+// The distance is returned from Lidar_getDistanceCm()
 void Lidar_distancePoll();
 
-// Returns the most recent polled distance in cm
-// Returns -1 if LIDAR is disconnected
+// Returns the filtered distance in cm
+// Returns -1 if LIDAR is disconnected or none of the last 8 frames was good
 short Lidar_getDistanceCm();
 
+// Returns the filtered distance with its confidence
+Range Lidar_getRange();
+
+// Returns the most recent frame, unfiltered, with its receive timestamp
+LidarFrame Lidar_getFrame();
+
+// Returns the number of good frames parsed since setup
+uint32_t Lidar_getFrameCount();
+
 // Returns if the LIDAR is locked,
 bool Lidar_isLocked();
 
+// Calls callback from the RX interrupt once a frame's worth of bytes is
+// waiting to be polled, at most 8 bytes after a frame has arrived
+void Lidar_setFrameCallback(void (*callback)(void));
+
 #endif
@@ -3,7 +3,7 @@
 / ---------------------------------------------------------------------------- /
 /	Bowie Gian
 /	Created: 2023-06-30
-/	Modified: 2023-07-26
+/	Modified: 2026-10-17
 /
 /	This file contains the main function for the IFOBS.
 / ----------------------------------------------------------------------------*/
@@ -13,13 +13,16 @@
 /*--------------------------------------------------------------*/
 
 #include <stdio.h>
-#include "pico/stdio.h"
-#include "pico/time.h"
-#include "tusb.h"
+#include "hal.h"
 #include "accelerometer.h"
 #include "ballistics.h"
+#include "capture.h"
+#include "display.h"
 #include "lidar.h"
-#include "oled.h"
+#include "probe.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "trace.h"
 
 /*--------------------------------------------------------------*/
 /* Definitions													*/
@@ -27,80 +30,248 @@
 
 #define SERIAL_MONITOR_WAIT 0
 
+// Task periods and deadlines
+#define ACCEL_PERIOD_US 50000		// Only as a fallback, every FIFO drain releases it
+#define ACCEL_DEADLINE_US 10000
+#define LIDAR_PERIOD_US 50000		// Only to notice a disconnect, frames release it
+#define LIDAR_DEADLINE_US 5000
+#define BUTTON_PERIOD_US 20000		// 50 Hz
+#define BUTTON_DEADLINE_US 20000
+#define DISPLAY_DEADLINE_US 33333		// Period is in display.h, the OLED times by it too
+#define TRACE_PERIOD_US 10000		// 100 Hz, keeps up with the capture too
+#define TRACE_DEADLINE_US 10000
+
 /*--------------------------------------------------------------*/
 /* Global Variables				 								*/
 /*--------------------------------------------------------------*/
 
 short distance_cm = 0;
 double distance_m = 0;
+double radialVelocity_mps = 0;
+
+// Leads the aim point for a target moving along the line of sight
+static bool isLeading = false;
+static Solution lastSolution;
+
+static int accelTaskId = -1;
+static int lidarTaskId = -1;
+static int displayTaskId = -1;
 
 /*--------------------------------------------------------------*/
-/* Main Function												*/
+/*  Static Function Implemetations								*/
 /*--------------------------------------------------------------*/
 
-int main()
+static void printBallistics(const BallisticsSolution *ballistics)
 {
-	// Initialize serial port
-	stdio_init_all();
+	printf("tof %.3f s, drop %.3f m, drift %.3f m, %.0f m/s left, lead %.2f px per m/s, "
+			"target %.2f m/s to %.1f m\r\n", ballistics->time_s, ballistics->drop_m,
+			ballistics->drift_m, ballistics->velocity_mps,
+			ballistics->leadPerMps_q8 / (double)(1 << BALLISTICS_Q8_SHIFT),
+			ballistics->radialVelocity_mps, ballistics->impactDistance_m);
+}
 
-	// Time to start monitoring serial port
-#if SERIAL_MONITOR_WAIT == 1
-	cdcd_init();
-	printf("waiting for usb host");
-	while (!tud_cdc_connected()) {
-		printf(".");
-		sleep_ms(500);
+// Serial commands, "p0" - "p3" selects a profile, "w0" - "w9" averages the
+// angles over 2^n samples, "f0" - "f2" picks the angle filter (average,
+// complementary, Kalman), "s" prints the task stats, "t" prints the stage
+// timings since the last "t", "c1" / "c0" starts and stops the sensor capture,
+// "l1" / "l0" turns the radial lead on and off and "b" prints the ballistics
+static void serialPoll()
+{
+	static int lastC = 0;
+	int c;
+
+	while ((c = Hal_serialGetc()) >= 0) {
+		if (lastC == 'p' && c >= '0' && c < '0' + PROFILE_COUNT) {
+			Profile_select(c - '0');
+		} else if (lastC == 'w' && c >= '0' && c <= '9') {
+			Accel_setWindow(1 << (c - '0'));
+			printf("angle window %d samples\r\n", Accel_getWindow());
+		} else if (lastC == 'f' && c >= '0' && c <= '2') {
+			Accel_setFilter((AccelFilter)(c - '0'));
+		} else if (lastC == 'c' && (c == '0' || c == '1')) {
+			Capture_setEnabled(c == '1');
+			if (c == '1') {
+				printf("capture on\r\n");
+			} else {
+				printf("capture off, %u packets dropped\r\n",
+						(unsigned)Capture_getDroppedCount());
+			}
+		} else if (lastC == 'l' && (c == '0' || c == '1')) {
+			isLeading = c == '1';
+			printf("lead %s\r\n", isLeading ? "on" : "off");
+		} else if (c == 'b') {
+			printBallistics(&lastSolution.ballistics);
+		} else if (c == 's') {
+			Scheduler_report();
+		} else if (c == 't') {
+			Probe_report();
+		}
+		lastC = c;
+	}
+}
+
+// Released from the interrupt after the FIFO is drained
+static void onAccelSamples()
+{
+	Scheduler_release(accelTaskId);
+}
+
+// Released by onAccelSamples
+static void accelTask()
+{
+	PROBE_BEGIN(PROBE_ACCEL_POLL);
+	Accel_poll();
+	PROBE_END(PROBE_ACCEL_POLL);
+}
+
+// Released by the RX interrupt as each frame arrives
+static void lidarTask()
+{
+	PROBE_BEGIN(PROBE_LIDAR_POLL);
+	Lidar_distancePoll();
+	PROBE_END(PROBE_LIDAR_POLL);
+
+	if (!Lidar_isLocked()) {
+		distance_cm = Lidar_getDistanceCm();
+		// distance_cm = 17900;
+		distance_m = (double)distance_cm / 100.0;
+		radialVelocity_mps = Lidar_getRange().velocity_cms / 100.0;
+	} else {
+		// A locked range doesn't follow the target
+		radialVelocity_mps = 0;
+	}
+}
+
+static void onLidarFrame()
+{
+	Scheduler_release(lidarTaskId);
+}
+
+static void buttonTask()
+{
+	Lidar_buttonPoll();
+
+	serialPoll();
+	Profile_poll();
+	if (Profile_isChanged()) {
+		Ballistics_setProfile(Profile_getActive());
 	}
-	printf("\nusb host detected!\n");
+}
+
+#if TRACE == 1
+static void traceSolution(const Solution *solution, uint32_t ballisticsUs)
+{
+	TraceRecord record;
+	LidarFrame frame = Lidar_getFrame();
+
+	record.timeUs = (uint32_t)Hal_timeUs();
+	record.sampleUs = (uint32_t)solution->sampleUs;
+	Accel_getSample(record.accel);
+	record.distance_cm = solution->distance_cm;
+	record.rawDistance_cm = frame.distance_cm;
+	record.strength = frame.strength;
+	record.confidence = Lidar_getRange().confidence;
+	record.elev_cdeg = (int16_t)(solution->elev_deg * 100);
+	record.cant_cdeg = (int16_t)(solution->cant_deg * 100);
+	record.xOffset = (int16_t)solution->xOffset;
+	record.zOffset = (int16_t)solution->zOffset;
+	record.flags = solution->isLocked ? TRACE_FLAG_LOCKED : 0;
+
+	record.stageUs[TRACE_STAGE_ACCEL] =
+			Trace_clampUs(Scheduler_getStats(accelTaskId).lastRunUs);
+	record.stageUs[TRACE_STAGE_LIDAR] =
+			Trace_clampUs(Scheduler_getStats(lidarTaskId).lastRunUs);
+	record.stageUs[TRACE_STAGE_BALLISTICS] = Trace_clampUs(ballisticsUs);
+	record.stageUs[TRACE_STAGE_DISPLAY] =
+			Trace_clampUs(Scheduler_getStats(displayTaskId).lastRunUs);
+
+	Trace_record(&record);
+}
 #endif
 
-	Oled_setup();
-	Accel_setup();
-	Lidar_setup();
+static void displayTask()
+{
+	Angle angles = Accel_getAngle();
+	Solution solution;
+	uint64_t startUs = Hal_timeUs();
 
-	Oled_displayCenter();
+	Ballistics_poll();
 
-	while (true) {
-		Angle angles;
+	BallisticsSolution ballistics = {0};
+	if (distance_cm != LIDAR_DC && distance_cm != LIDAR_MAX_CM) {
+		PROBE_BEGIN(PROBE_BALLISTICS);
+		Ballistics_solve(distance_m, isLeading ? radialVelocity_mps : 0, angles.theta,
+				angles.alpha, &ballistics);
+		PROBE_END(PROBE_BALLISTICS);
+	}
+	int xOffset = BALLISTICS_Q8_TO_PIXELS(ballistics.xOffset_q8);
+	int yOffset = BALLISTICS_Q8_TO_PIXELS(ballistics.zOffset_q8);
 
-		Accel_poll();
-		angles = Accel_getAngle();
+	uint32_t ballisticsUs = (uint32_t)(Hal_timeUs() - startUs);
 
-		Oled_brightnessPoll();
-		Lidar_buttonPoll();
+	solution.sampleUs = Accel_getSampleTimeUs();
+	solution.distance_cm = distance_cm;
+	solution.isLocked = Lidar_isLocked();
+	solution.elev_deg = angles.theta;
+	solution.cant_deg = angles.alpha;
+	solution.xOffset = xOffset;
+	solution.zOffset = yOffset;
+	solution.ballistics = ballistics;
+	Display_publish(&solution);
+	lastSolution = solution;
 
-		if (Lidar_isLocked()) {
-			Oled_displayLock();
-		} else {
-			Oled_clearLock();
+#if TRACE == 1
+	traceSolution(&solution, ballisticsUs);
+#else
+	(void)ballisticsUs;
+	printf("%d %d %d\r\n\n\n", distance_cm, xOffset, yOffset);
+#endif
+}
 
-			Lidar_distancePoll();
-			distance_cm = Lidar_getDistanceCm();
-			// distance_cm = 17900;
-			distance_m = (double)distance_cm / 100.0;
-		}
+/*--------------------------------------------------------------*/
+/* Main Function												*/
+/*--------------------------------------------------------------*/
 
-		int xOffset = 0;
-		int yOffset = 0;
-		if (distance_cm != LIDAR_DC && distance_cm != LIDAR_MAX_CM) {
-			Ballistics_calculatePixelOffset(distance_m, angles.theta,
-					angles.alpha, &xOffset, &yOffset);
-		}
+int main()
+{
+	// Initialize serial port
+	Hal_init();
 
-		printf("%d %d %d\r\n", distance_cm, xOffset, yOffset);
-		Oled_displayDistance(distance_cm);
-		Oled_displayElevation(angles.theta);
-		Oled_displayCant(angles.alpha);
+	// Time to start monitoring serial port
+#if SERIAL_MONITOR_WAIT == 1
+	Hal_waitForUsbHost();
+#endif
 
-		int statusOled = Oled_displayCalcDot(xOffset, yOffset);
+	// Core 1 sets up the OLED and draws every solution from here on
+	Display_start();
+	Accel_setup();
+	Lidar_setup();
+	Profile_setup();
+	Ballistics_setup();
 
-		if (statusOled == OLED_OFF_SCREEN) {
-			Oled_displayCalcDotErr();
-		} else if (statusOled == OLED_SUCCESS) {
-			Oled_clearCalcDotErr();
-		}
-		
-		printf("\r\n\n");
-		sleep_ms(100);
+	accelTaskId = Scheduler_addTask("accel", accelTask, ACCEL_PERIOD_US,
+			ACCEL_DEADLINE_US);
+	lidarTaskId = Scheduler_addTask("lidar", lidarTask, LIDAR_PERIOD_US,
+			LIDAR_DEADLINE_US);
+	Scheduler_addTask("buttons", buttonTask, BUTTON_PERIOD_US, BUTTON_DEADLINE_US);
+	displayTaskId = Scheduler_addTask("display", displayTask, DISPLAY_PERIOD_US,
+			DISPLAY_DEADLINE_US);
+	// Sends the capture packets as well as the trace records
+	Scheduler_addTask("trace", Trace_drain, TRACE_PERIOD_US, TRACE_DEADLINE_US);
+	Accel_setSampleCallback(onAccelSamples);
+	Lidar_setFrameCallback(onLidarFrame);
+
+	// Each pass ends just after a display release
+	uint64_t frameUs = Hal_timeUs();
+	while (Hal_isRunning()) {
+		frameUs += DISPLAY_PERIOD_US;
+		Scheduler_runUntil(frameUs);
 	}
+
+	Display_stop();
+	Profile_flush();
+	Scheduler_report();
+	Probe_report();
+
+	return 0;
 }
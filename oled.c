@@ -3,10 +3,40 @@
 / ---------------------------------------------------------------------------- /
 /	Bowie Gian
 /	Created: 2023-06-30
-/	Modified: 2023-07-28
+/	Modified: 2026-10-17
 /
 /	This file contains the functions that will drive the OLED screen.
 /	The SPI setup is modified from the accelerometer example.
+/
+/	All drawing goes into a RAM copy of the display (frameBuffer). Each page
+/	tracks the span of columns that changed, and Oled_flush() sends only
+/	those spans, merging neighbouring pages into one window when that is
+/	cheaper than addressing them separately.
+/
+/	Text is drawn by drawText() from one font atlas: fontColumns holds the
+/	columns of every glyph back to back and font[] maps a character to its
+/	offset and width, so a string is a single pass of table lookups.
+/	Numbers are turned into characters with digitPairs and a multiply and
+/	shift for the hundreds instead of dividing by 10.
+/
+/	Each HUD field keeps the value it last drew (lastDistance and so on)
+/	and does nothing when asked to draw it again, so a frame where nothing
+/	changed doesn't format text or touch the frame buffer. This matters for
+/	the dot too: moving it clears the old column before drawing the new
+/	one, which would mark the page dirty and resend it even when the dot
+/	hadn't moved.
+/
+/	The dot stays measured from the crosshair, which is the line of sight,
+/	but with AIM_EXTENDED it may go anywhere on the panel, not just the
+/	window around the crosshair, so long holdovers and high cant still get
+/	a dot. The text fields are keep-out zones (keepOuts) where the dot is
+/	treated as off screen, since clearing it would wipe out the text.
+/	Either way only the dot's own columns are redrawn when it moves.
+/
+/	The flush copies the windows into txBuffer and hands them to DMA. Each
+/	window is a command transfer (DC low) followed by a data transfer
+/	(DC high) under one CS cycle, chained from the DMA done callback, so
+/	drawing the next frame overlaps with sending this one.
 / ----------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------*/
@@ -15,8 +45,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include "pico/stdlib.h"
-#include "hardware/spi.h"
+#include <string.h>
+#include "ballistics.h"
+#include "display.h"
+#include "hal.h"
 #include "oled.h"
 #include "lidar.h"
 
@@ -24,14 +56,32 @@
 /* Definitions													*/
 /*--------------------------------------------------------------*/
 
-#define DEBUG 1
-
 // 0 = Dot, 1 = Cross
 #define DOT_OR_CROSS 1
 
+// 1 alternates the reticle between its nearest half pixel positions over
+// RETICLE_DITHER_FRAMES frames, so on average it sits at the exact offset
+// 0 rounds it to the nearest half pixel
+#define RETICLE_DITHER 1
+#define RETICLE_DITHER_FRAMES 4
+#define RETICLE_HALF_Q8 128
+
+// 1 lets the dot go anywhere on the panel that isn't text, 0 keeps it in
+// the window around the crosshair
+#define AIM_EXTENDED 1
+#define AIM_WINDOW_LEFT -16
+#define AIM_WINDOW_RIGHT 16
+#define AIM_WINDOW_BOTTOM -24
+#define AIM_WINDOW_TOP 16
+
 #define NUM_BRIGHTNESS 8
-#define BRIGHTNESS_DISPLAY_LENGTH 5
-#define DISABLE_HOLD_LENGTH 10
+#define BRIGHTNESS_DISPLAY_MS 500
+#define DISABLE_HOLD_MS 1000
+
+// The brightness poll runs once per draw, so durations count in frames
+#define MS_TO_FRAMES(ms) (((ms) * 1000 + DISPLAY_PERIOD_US / 2) / DISPLAY_PERIOD_US)
+#define BRIGHTNESS_DISPLAY_LENGTH MS_TO_FRAMES(BRIGHTNESS_DISPLAY_MS)
+#define DISABLE_HOLD_LENGTH MS_TO_FRAMES(DISABLE_HOLD_MS)
 
 // Pins
 #define PIN_CS		5 // SPI CS
@@ -47,17 +97,89 @@
 #define OLED_DC_COMD 0 // command
 #define OLED_DC_DATA 1 // data
 
+#define NUM_PAGES 8
+#define NUM_COLS 128
+
+// Cost of addressing a window (6 command bytes and a DMA restart) in bytes,
+// used to decide if two dirty pages are cheaper to send as one window
+#define WINDOW_OVERHEAD 8
+
+// Characters in the font atlas that aren't ASCII
+#define CHAR_DEG 0x01
+#define CHAR_LOCK 0x02
+
+// Text fields, the columns they cover
+#define DIST_DISP_WIDTH 17			// "123m"
+#define ANGLE_DISP_WIDTH 19			// "+123" and a degree sign
+
+// n / 100 as a multiply and shift, the M0+ has no divide instruction
+#define DIV100_SMALL(n) (((n) * 41) >> 12)		// Right below 1000
+#define DIV100(n) (((n) * 5243) >> 19)			// Right below 43699
+#define DIV100_MAX 43600
+
+// Marks a field's cached value as unknown, so it is drawn next time
+#define FIELD_NONE INT32_MIN
+#define FIELD_ERR -1
+#define FIELD_MAX -2
+
 #define DOT_CENTER_COL 0x3C
 #define DOT_CENTER_PAGE 0x05
 #define DIST_DISP_COL (DOT_CENTER_COL - 0x08)
 #define DIST_DISP_PAGE 0x07
+#define LOCK_DISP_COL (DIST_DISP_COL - 6)
+#define LOCK_DISP_WIDTH 5
+#define BRIGHTNESS_DISP_COL (DIST_DISP_COL - 0x10)
+#define BRIGHTNESS_DISP_PAGE 0x03
+#define BRIGHTNESS_DISP_WIDTH 3
+#define ELEV_DISP_COL 0x4C
+#define ELEV_DISP_PAGE 0x03
+#define CANT_DISP_COL 0x36
+#define CANT_DISP_PAGE 0x01
+#define DOT_ERR_COL 0x20
+#define DOT_ERR_PAGE 0x02
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	uint8_t offset;				// Into fontColumns
+	uint8_t width;
+} Glyph;
+
+// Columns of a page the dot must not be drawn over
+typedef struct {
+	uint8_t page;
+	uint8_t colStart;
+	uint8_t colEnd;
+} KeepOut;
 
 /*--------------------------------------------------------------*/
 /* Global Variables				 								*/
 /*--------------------------------------------------------------*/
 
+#if AIM_EXTENDED == 1
+// The text, which the dot would wipe out when it moves on
+static const KeepOut keepOuts[] = {
+	{DIST_DISP_PAGE, LOCK_DISP_COL, DIST_DISP_COL + DIST_DISP_WIDTH - 1},
+	{BRIGHTNESS_DISP_PAGE, BRIGHTNESS_DISP_COL, BRIGHTNESS_DISP_COL + BRIGHTNESS_DISP_WIDTH - 1},
+	{ELEV_DISP_PAGE, ELEV_DISP_COL, ELEV_DISP_COL + ANGLE_DISP_WIDTH - 1},
+	{CANT_DISP_PAGE, CANT_DISP_COL, CANT_DISP_COL + ANGLE_DISP_WIDTH - 1},
+	{DOT_ERR_PAGE, DOT_ERR_COL, DOT_ERR_COL},
+};
+#endif
+
 static uint8_t curCalcDotCol = DOT_CENTER_COL;
 static uint8_t curCalcDotPage = 0x03;
+static int curCalcDotWidth = 1;
+static int curCalcDotPages = 1;
+
+#if RETICLE_DITHER == 1
+// Where a frame rounds between half pixels, in an order that spreads the
+// rounding up over the cycle
+static const uint8_t ditherThresholds[RETICLE_DITHER_FRAMES] = {16, 80, 48, 112};
+static uint32_t ditherFrame = 0;
+#endif
 
 static bool prevButtonUp = false;
 static bool prevButtonDown = false;
@@ -78,36 +200,85 @@ static int brightnessDisplayCount = -1;
 static int bothButtonHoldCount = 0;
 static bool disableStats = false;
 
+// What each field shows, a field is only drawn when its value changes
+static int lastDistance = FIELD_NONE;		// Meters, FIELD_ERR or FIELD_MAX
+static int lastElevation = FIELD_NONE;		// Whole degrees, ~ of them below 0
+static int lastCant = FIELD_NONE;
+static int lastLock = FIELD_NONE;			// 1 shown, 0 cleared
+static int lastDotX = FIELD_NONE;
+static int lastDotY = FIELD_NONE;
+static int lastDotWidth = 1;
+static int lastDotHeight = 1;
+static int lastDotStatus = OLED_SUCCESS;
+
 #if DOT_OR_CROSS == 1
 static int prevXOffset = 0;
 static int prevYOffset = 0;
 #endif
 
-static spi_inst_t *spi;
-
-// Pixel arrays for OLED
-// Change to struct with its length for the future ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-static uint8_t number[10][3] = {
-	{0xFE, 0x82, 0xFE},	// 0
-	{0x42, 0xFE, 0x02},	// 1
-	{0x9E, 0x92, 0xF2},	// 2
-	{0x92, 0x92, 0xFE},	// 3
-	{0xF0, 0x10, 0xFE},	// 4
-	{0xF2, 0x92, 0x9E},	// 5
-	{0xFE, 0x92, 0x9E},	// 6
-	{0x80, 0x80, 0xFE},	// 7
-	{0xFE, 0x92, 0xFE},	// 8
-	{0xF0, 0x90, 0xFE}	// 9
+static const HalSpi spi = HAL_SPI0;
+
+// RAM copy of the display, one byte is a column of 8 pixels in a page
+static uint8_t frameBuffer[NUM_PAGES][NUM_COLS];
+
+// Columns changed since the last flush, the page is clean if start > end
+static int dirtyStart[NUM_PAGES];
+static int dirtyEnd[NUM_PAGES];
+
+// Windows of a flush in progress, sent by DMA out of txBuffer
+typedef struct {
+	uint8_t command[6];
+	uint16_t offset;
+	uint16_t length;
+} FlushWindow;
+
+static uint8_t txBuffer[NUM_PAGES * NUM_COLS];
+static FlushWindow flushWindows[NUM_PAGES];
+static int numFlushWindows = 0;
+static volatile int flushWindowIndex = 0;
+static volatile bool isFlushData = false;
+
+// Font atlas, the columns of every glyph back to back
+static const uint8_t fontColumns[] = {
+	0xFE, 0x82, 0xFE,				// 0
+	0x42, 0xFE, 0x02,				// 1
+	0x9E, 0x92, 0xF2,				// 2
+	0x92, 0x92, 0xFE,				// 3
+	0xF0, 0x10, 0xFE,				// 4
+	0xF2, 0x92, 0x9E,				// 5
+	0xFE, 0x92, 0x9E,				// 6
+	0x80, 0x80, 0xFE,				// 7
+	0xFE, 0x92, 0xFE,				// 8
+	0xF0, 0x90, 0xFE,				// 9
+	0xFE, 0x92, 0x92,				// E
+	0xFE, 0x02, 0x02,				// L
+	0xFE, 0xB0, 0xEE,				// R
+	0x10, 0x38, 0x10,				// +
+	0x10, 0x10, 0x10,				// -
+	0xE0, 0xA0, 0xE0,				// Degree
+	0x1E, 0x10, 0x0E, 0x10, 0x0E,	// m
+	0x0E, 0x7E, 0x4A, 0x7E, 0x0E,	// Lock
+};
+
+// Where each character's columns start in the atlas, characters without a
+// glyph have a width of 0 and are skipped
+static const Glyph font[128] = {
+	['0'] = {0, 3}, ['1'] = {3, 3}, ['2'] = {6, 3}, ['3'] = {9, 3}, ['4'] = {12, 3},
+	['5'] = {15, 3}, ['6'] = {18, 3}, ['7'] = {21, 3}, ['8'] = {24, 3}, ['9'] = {27, 3},
+	['E'] = {30, 3}, ['L'] = {33, 3}, ['R'] = {36, 3}, ['+'] = {39, 3}, ['-'] = {42, 3},
+	[CHAR_DEG] = {45, 3}, ['m'] = {48, 5}, [CHAR_LOCK] = {53, 5},
 };
 
-static uint8_t letterE[3] = {0xFE, 0x92, 0x92};
-static uint8_t letterM[5] = {0x1E, 0x10, 0x0E, 0x10, 0x0E};
-static uint8_t letterL[3] = {0xFE, 0x02, 0x02};
-static uint8_t letterR[3] = {0xFE, 0xB0, 0xEE};
-static uint8_t symbolDeg[3] = {0xE0, 0xA0, 0xE0};
-static uint8_t symbolPlus[3] = {0x10, 0x38, 0x10};
-static uint8_t symbolNeg[3] = {0x10, 0x10, 0x10};
-static uint8_t symbolLock[5] = {0x0E, 0x7E, 0x4A, 0x7E, 0x0E};
+// "00" to "99", the last two digits of a number without dividing by 10
+static const char digitPairs[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+// Crosshair around the center dot on DOT_CENTER_PAGE
+static const uint8_t crossSides = 0x01;
+static const uint8_t crossCenter = 0x78;
+static const uint8_t crossBottom = 0x3C;
 
 /*--------------------------------------------------------------*/
 /*  Static Function Implemetations								*/
@@ -115,163 +286,217 @@ static uint8_t symbolLock[5] = {0x0E, 0x7E, 0x4A, 0x7E, 0x0E};
 
 static void setupSPI()
 {
-	spi = spi0; // Link spi0 port
-
 	// Initialize SPI port at 1 MHz
-	spi_init(spi, 1000 * 1000);
+	Hal_spiInit(spi, 1000 * 1000);
 
-	// Set SPI format
-	spi_set_format( spi0,   // SPI instance
-					8,      // Number of bits per transfer
-					1,      // Polarity (CPOL)
-					1,      // Phase (CPHA)
-					SPI_MSB_FIRST);
+	// Set SPI format (MSB first)
+	Hal_spiSetFormat(	spi,    // SPI instance
+						8,      // Number of bits per transfer
+						1,      // Polarity (CPOL)
+						1);     // Phase (CPHA)
 
 	// Initialize SPI pins
-	gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
-	gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
+	Hal_gpioSetFunction(PIN_SCK, HAL_GPIO_FUNC_SPI);
+	Hal_gpioSetFunction(PIN_MOSI, HAL_GPIO_FUNC_SPI);
 }
 
 // Initializes GPIO pins
 // CS: HIGH, DC: LOW, RST: HIGH
 static void setupGPIO()
 {
-	gpio_init(PIN_CS);
-	gpio_set_dir(PIN_CS, GPIO_OUT);
-	gpio_put(PIN_CS, 1);
+	Hal_gpioInit(PIN_CS);
+	Hal_gpioSetDir(PIN_CS, HAL_GPIO_OUT);
+	Hal_gpioPut(PIN_CS, 1);
 
-	gpio_init(PIN_DC);
-	gpio_set_dir(PIN_DC, GPIO_OUT);
-	gpio_put(PIN_DC, OLED_DC_COMD);
+	Hal_gpioInit(PIN_DC);
+	Hal_gpioSetDir(PIN_DC, HAL_GPIO_OUT);
+	Hal_gpioPut(PIN_DC, OLED_DC_COMD);
 
-	gpio_init(PIN_RST);
-	gpio_set_dir(PIN_RST, GPIO_OUT);
-	gpio_put(PIN_RST, 1);
+	Hal_gpioInit(PIN_RST);
+	Hal_gpioSetDir(PIN_RST, HAL_GPIO_OUT);
+	Hal_gpioPut(PIN_RST, 1);
 
-	gpio_init(BUTTON_UP);
-	gpio_set_dir(BUTTON_UP, GPIO_IN);
-	gpio_pull_up(BUTTON_UP);
+	Hal_gpioInit(BUTTON_UP);
+	Hal_gpioSetDir(BUTTON_UP, HAL_GPIO_IN);
+	Hal_gpioPullUp(BUTTON_UP);
 
-	gpio_init(BUTTON_DOWN);
-	gpio_set_dir(BUTTON_DOWN, GPIO_IN);
-	gpio_pull_up(BUTTON_DOWN);
+	Hal_gpioInit(BUTTON_DOWN);
+	Hal_gpioSetDir(BUTTON_DOWN, HAL_GPIO_IN);
+	Hal_gpioPullUp(BUTTON_DOWN);
 }
 
-static void setColumnRange(uint8_t start, uint8_t end)
+// Blocking command write, waits for a flush in progress to finish first
+static void sendCommand(const uint8_t *data, size_t len)
 {
-	uint8_t data;
+	Hal_spiDmaWait(spi);
 
-	gpio_put(PIN_DC, OLED_DC_COMD);
-	gpio_put(PIN_CS, 0);
+	Hal_gpioPut(PIN_DC, OLED_DC_COMD);
+	Hal_gpioPut(PIN_CS, 0);
 	{
-		// Column Range Command
-		data = 0x21;
-		spi_write_blocking(spi, &data, 1);
+		Hal_spiWrite(spi, data, len);
+	}
+	Hal_gpioPut(PIN_CS, 1);
+}
+
+static void markClean(int page)
+{
+	dirtyStart[page] = NUM_COLS;
+	dirtyEnd[page] = -1;
+}
+
+static void markDirty(int page, int start, int end)
+{
+	if (start < dirtyStart[page])
+		dirtyStart[page] = start;
 
-		// Set Start Column
-		spi_write_blocking(spi, &start, 1);
+	if (end > dirtyEnd[page])
+		dirtyEnd[page] = end;
+}
 
-		// Set End Column
-		spi_write_blocking(spi, &end, 1);
+// Forces the next flush to resend the whole screen
+static void invalidate()
+{
+	for (int page = 0; page < NUM_PAGES; page++) {
+		markDirty(page, 0, NUM_COLS - 1);
 	}
-	gpio_put(PIN_CS, 1);
 }
 
-static void setPageRange(uint8_t start, uint8_t end)
+// Writes one column of 8 pixels, off screen columns are ignored
+static void setColumn(int page, int col, uint8_t value)
 {
-#if DEBUG == 1
-	if (start > 0x07)
-		printf("DEBUG: setPageRange start value > 7\r\n");
+	if (col < 0 || col >= NUM_COLS || frameBuffer[page][col] == value) {
+		return;
+	}
 
-	if (end > 0x07)
-		printf("DEBUG: setPageRange end value > 7\r\n");
-#endif
-	uint8_t data;
+	frameBuffer[page][col] = value;
+	markDirty(page, col, col);
+}
 
-	gpio_put(PIN_DC, OLED_DC_COMD);
-	gpio_put(PIN_CS, 0);
-	{
-		// Page Range Command
-		data = 0x22;
-		spi_write_blocking(spi, &data, 1);
+// Blanks width columns at col and returns the column after them
+static int blank(int page, int col, int width)
+{
+	for (int i = 0; i < width; i++) {
+		setColumn(page, col + i, 0x00);
+	}
+	return col + width;
+}
+
+// Draws text at col with a blank column between the glyphs, and blanks
+// the rest of the field so a shorter text leaves nothing behind
+static void drawText(int page, int col, const char *text, int width)
+{
+	int end = col + width;
 
-		// Set Start Page
-		spi_write_blocking(spi, &start, 1);
+	for (int i = 0; text[i] != '\0'; i++) {
+		const Glyph *glyph = &font[text[i] & 0x7F];
+		const uint8_t *columns = &fontColumns[glyph->offset];
 
-		// Set End Page
-		spi_write_blocking(spi, &end, 1);
+		if (i > 0) {
+			setColumn(page, col++, 0x00);
+		}
+		for (int j = 0; j < glyph->width; j++) {
+			setColumn(page, col++, columns[j]);
+		}
 	}
-	gpio_put(PIN_CS, 1);
+	blank(page, col, end - col);
 }
 
-// Sends the array of pixels to the OLED
-// ASSUMES: PIN_DC = OLED_DC_DATA, PIN_CS = 0
-static void display(uint8_t *columnArray, int width)
+// Writes n (0 - 999) as 3 digits and returns the end of them
+static char *formatDigits(char *text, int n)
 {
-	for (int i = 0; i < width; i++) {
-		spi_write_blocking(spi, &columnArray[i], 1);
+	int hundreds = DIV100_SMALL(n);
+	const char *pair = &digitPairs[2 * (n - hundreds * 100)];
+
+	text[0] = (char)('0' + hundreds);
+	text[1] = pair[0];
+	text[2] = pair[1];
+	return text + 3;
+}
+
+static void onFlushDma();
+
+// Starts the command half of the current window
+static void startFlushWindow()
+{
+	isFlushData = false;
+	Hal_gpioPut(PIN_DC, OLED_DC_COMD);
+	Hal_gpioPut(PIN_CS, 0);
+	Hal_spiWriteDma(spi, flushWindows[flushWindowIndex].command, 6, onFlushDma);
+}
+
+// DMA done callback (interrupt context), steps through the windows
+static void onFlushDma()
+{
+	FlushWindow *window = &flushWindows[flushWindowIndex];
+
+	if (!isFlushData) {
+		isFlushData = true;
+		Hal_gpioPut(PIN_DC, OLED_DC_DATA);
+		Hal_spiWriteDma(spi, &txBuffer[window->offset], window->length, onFlushDma);
+		return;
+	}
+
+	Hal_gpioPut(PIN_CS, 1);
+
+	if (flushWindowIndex + 1 < numFlushWindows) {
+		flushWindowIndex++;
+		startFlushWindow();
 	}
 }
 
+// Copies one window of the frame buffer to txBuffer and queues it
+static void queueWindow(int pageStart, int pageEnd, int colStart, int colEnd)
+{
+	FlushWindow *window = &flushWindows[numFlushWindows];
+	int width = colEnd - colStart + 1;
+	int offset = numFlushWindows > 0
+			? flushWindows[numFlushWindows - 1].offset + flushWindows[numFlushWindows - 1].length
+			: 0;
+
+	window->command[0] = 0x21;		// Column Range Command
+	window->command[1] = colStart;
+	window->command[2] = colEnd;
+	window->command[3] = 0x22;		// Page Range Command
+	window->command[4] = pageStart;
+	window->command[5] = pageEnd;
+	window->offset = offset;
+	window->length = 0;
+
+	for (int page = pageStart; page <= pageEnd; page++) {
+		memcpy(&txBuffer[offset + window->length], &frameBuffer[page][colStart], width);
+		window->length += width;
+	}
+
+	numFlushWindows++;
+}
+
 // Clears the calculated dot.
 // Module keeps track of this dot and only clears that byte.
 static void clearCalcDot()
 {
-	setColumnRange(curCalcDotCol, curCalcDotCol);
-	setPageRange(curCalcDotPage, curCalcDotPage);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		uint8_t blank = 0;
-		spi_write_blocking(spi, &blank, 1);
+	for (int page = 0; page < curCalcDotPages; page++) {
+		blank(curCalcDotPage + page, curCalcDotCol, curCalcDotWidth);
 	}
-	gpio_put(PIN_CS, 1);
 }
 
 // Draws the brightnessIndex + 1 on screen (offset the 0)
 static void displayBrightnessSetting()
 {
-	setColumnRange(DIST_DISP_COL - 0x10, 0x7F);
-	setPageRange(0x03, 0x03);
+	char text[2] = {(char)('1' + brightnessIndex), '\0'};
 
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		display(number[brightnessIndex + 1], 3);
-	}
-	gpio_put(PIN_CS, 1);
+	drawText(BRIGHTNESS_DISP_PAGE, BRIGHTNESS_DISP_COL, text, BRIGHTNESS_DISP_WIDTH);
 }
 
 // Clears the brightnessIndex
 static void clearBrightnessSetting()
 {
-	setColumnRange(DIST_DISP_COL - 0x10, 0x7F);
-	setPageRange(0x03, 0x03);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		u_int8_t blank = 0x00;
-		for (int i = 0; i < 3; i++) {
-			spi_write_blocking(spi, &blank, 1);
-		}
-	}
-	gpio_put(PIN_CS, 1);
+	blank(BRIGHTNESS_DISP_PAGE, BRIGHTNESS_DISP_COL, BRIGHTNESS_DISP_WIDTH);
 }
 
 static void setBrightness(uint8_t brightness) {
-	uint8_t data; // Buffer to store output
+	uint8_t data[2] = {0x81, brightness};
 
-	gpio_put(PIN_DC, OLED_DC_COMD);
-	gpio_put(PIN_CS, 0);
-	{
-		data = 0x81;
-		spi_write_blocking(spi, &data, 1);
-		data = brightness;
-		spi_write_blocking(spi, &data, 1);
-	}
-	gpio_put(PIN_CS, 1);
+	sendCommand(data, 2);
 
 	displayBrightnessSetting();
 	brightnessDisplayCount = BRIGHTNESS_DISPLAY_LENGTH;
@@ -299,52 +524,205 @@ static void brightnessDown() {
 	printf("Brightness down %d\n", brightnessIndex);
 }
 
+// Forgets what the fields show, after something else drew over them
+static void resetFields()
+{
+	lastDistance = FIELD_NONE;
+	lastElevation = FIELD_NONE;
+	lastCant = FIELD_NONE;
+	lastLock = FIELD_NONE;
+	lastDotX = FIELD_NONE;
+	lastDotY = FIELD_NONE;
+}
+
+// Draws a sign or letter, then 3 digits, then the degree symbol
+// Does nothing if last says that is already on screen
+static void displayAngle(int page, int col, double angle, char positive, char negative,
+		int *last)
+{
+	bool isNegative = angle < 0;
+	int angleInt = (int)(isNegative ? -angle : angle);
+	char text[6];
+
+	if (angleInt > 999)
+		angleInt = 999;
+
+	// -0.5 shows as -000, so the sign is part of the value
+	int value = isNegative ? ~angleInt : angleInt;
+	if (value == *last) {
+		return;
+	}
+	*last = value;
+
+	text[0] = isNegative ? negative : positive;
+	char *end = formatDigits(&text[1], angleInt);
+	end[0] = CHAR_DEG;
+	end[1] = '\0';
+	drawText(page, col, text, ANGLE_DISP_WIDTH);
+}
+
+// Returns true if a width x height dot at the offset can be drawn
+static bool isDotOnScreen(int xOffset, int yOffset, int width, int height)
+{
+#if AIM_EXTENDED == 1
+	int col = DOT_CENTER_COL + xOffset;
+	int row = yOffset + DOT_CENTER_PAGE * 8;
+
+	if (col < 0 || col + width > NUM_COLS || row < 0 || row + height > NUM_PAGES * 8) {
+		return false;
+	}
+
+	for (size_t i = 0; i < sizeof(keepOuts) / sizeof(keepOuts[0]); i++) {
+		const KeepOut *keepOut = &keepOuts[i];
+
+		if (keepOut->page >= row / 8 && keepOut->page <= (row + height - 1) / 8
+				&& keepOut->colStart < col + width && keepOut->colEnd >= col) {
+			return false;
+		}
+	}
+	return true;
+#else
+	return xOffset >= AIM_WINDOW_LEFT && xOffset + width <= AIM_WINDOW_RIGHT
+			&& yOffset >= AIM_WINDOW_BOTTOM && yOffset + height <= AIM_WINDOW_TOP;
+#endif
+}
+
+// Moves the calculated dot, and the crosshair around it
+// The dot is width x height pixels from (xOffset, yOffset), 1 or 2 each way
+// Returns 0 on success, -1 on failure (off screen)
+static int drawCalcDot(int xOffset, int yOffset, int width, int height)
+{
+	clearCalcDot();
+#if DOT_OR_CROSS == 0
+	Oled_displayCenter();
+#endif
+
+	if (!isDotOnScreen(xOffset, yOffset, width, height)) {
+		curCalcDotCol = DOT_CENTER_COL;
+		curCalcDotPage = DOT_CENTER_PAGE;
+		curCalcDotWidth = 1;
+		curCalcDotPages = 1;
+#if DOT_OR_CROSS == 1
+		Oled_displayCenter();
+#endif
+		return OLED_OFF_SCREEN;
+	}
+
+#if DOT_OR_CROSS == 1
+	// If inside of crosshair
+	if (abs(xOffset) <= 9 && abs(yOffset) <= 9) {
+		// Draw part of crosshair
+		for (int i = 0; i < 13; i++) {
+			uint8_t value = 0x00;
+
+			if (i <= 3 && xOffset >= 0) {
+				value = crossSides;
+			} else if (i >= 9 && xOffset <= 0) {
+				value = crossSides;
+			} else if (i == 6 && yOffset <= 0) {
+				value = crossCenter;
+			}
+			setColumn(DOT_CENTER_PAGE, DOT_CENTER_COL - 6 + i, value);
+		}
+
+		if (yOffset >= 0) {
+			setColumn(DOT_CENTER_PAGE - 1, DOT_CENTER_COL, crossBottom);
+		}
+	} else {
+		Oled_displayCenter();
+	}
+#endif
+
+	// The rows can straddle two pages
+	int row = yOffset + DOT_CENTER_PAGE * 8;
+	uint8_t pixels[2] = {0x00, 0x00};
+
+	curCalcDotCol = DOT_CENTER_COL + xOffset;
+	curCalcDotPage = row / 8;
+	curCalcDotWidth = width;
+	curCalcDotPages = (row + height - 1) / 8 - curCalcDotPage + 1;
+
+	for (int i = row; i < row + height; i++) {
+		pixels[i / 8 - curCalcDotPage] |= 0x01 << (i % 8);
+	}
+
+	// On top of whatever of the crosshair is left there
+	for (int page = 0; page < curCalcDotPages; page++) {
+		for (int col = 0; col < width; col++) {
+			uint8_t value = frameBuffer[curCalcDotPage + page][curCalcDotCol + col];
+			setColumn(curCalcDotPage + page, curCalcDotCol + col, value | pixels[page]);
+		}
+	}
+
+	return OLED_SUCCESS;
+}
+
+// Draws the dot unless it is already there
+static int moveCalcDot(int xOffset, int yOffset, int width, int height)
+{
+	if (xOffset == lastDotX && yOffset == lastDotY
+			&& width == lastDotWidth && height == lastDotHeight) {
+		return lastDotStatus;
+	}
+	lastDotX = xOffset;
+	lastDotY = yOffset;
+	lastDotWidth = width;
+	lastDotHeight = height;
+	lastDotStatus = drawCalcDot(xOffset, yOffset, width, height);
+	return lastDotStatus;
+}
+
+// Q8 offset to the first pixel and the width of the dot for one axis
+// A whole pixel is drawn 1 wide, half way between two pixels both are lit,
+// and threshold (Q8 of half a pixel) decides which of the two is closer
+static void placeReticle(int32_t offset_q8, int threshold, int *first, int *size)
+{
+	int32_t halves = (offset_q8 + threshold) >> (BALLISTICS_Q8_SHIFT - 1);
+
+	*first = (int)(halves >> 1);
+	*size = 1 + (int)(halves & 1);
+}
+
 /*--------------------------------------------------------------*/
 /*  Function Implemetations										*/
 /*--------------------------------------------------------------*/
 
 void Oled_setup()
 {
-	uint8_t data; // Buffer to store output
-	
 	setupSPI();
 	setupGPIO();
 
-	gpio_put(PIN_DC, OLED_DC_COMD);
-	gpio_put(PIN_CS, 0);
 	{
 		// Remap (Flip Horizontally)
-		// data = 0xA1;
-		// spi_write_blocking(spi, &data, 1);
+		// 0xA1
 
 		// Set Horizonal Addr Mode
-		data = 0x20;
-		spi_write_blocking(spi, &data, 1);
-		data = 0x00;
-		spi_write_blocking(spi, &data, 1);
+		uint8_t data[2] = {0x20, 0x00};
+		sendCommand(data, 2);
 	}
-	gpio_put(PIN_CS, 1);
 
-	Oled_clear();
+	// Display RAM is undefined at power on, push the whole blank buffer
+	memset(frameBuffer, 0, sizeof(frameBuffer));
+	for (int page = 0; page < NUM_PAGES; page++) {
+		markClean(page);
+	}
+	invalidate();
+	Oled_flush();
 
-	gpio_put(PIN_DC, OLED_DC_COMD);
-	gpio_put(PIN_CS, 0);
 	{
-		// Set brightness without displaying index
-		data = 0x81;
-		spi_write_blocking(spi, &data, 1);
-		data = brightnessSettings[brightnessIndex];
-		spi_write_blocking(spi, &data, 1);
-		
-		// Turn on display
-		data = 0xAF;
-		spi_write_blocking(spi, &data, 1);
+		uint8_t data[3] = {
+			// Set brightness without displaying index
+			0x81, brightnessSettings[brightnessIndex],
+			// Turn on display
+			0xAF
+		};
+		sendCommand(data, 3);
 	}
 }
 
 void Oled_brightnessPoll() {
-	bool currButtonUp = !gpio_get(BUTTON_UP);
-	bool currButtonDown = !gpio_get(BUTTON_DOWN);
+	bool currButtonUp = !Hal_gpioGet(BUTTON_UP);
+	bool currButtonDown = !Hal_gpioGet(BUTTON_DOWN);
 
 	if (currButtonUp != prevButtonUp) {
 		if (currButtonUp) {
@@ -387,378 +765,198 @@ void Oled_brightnessPoll() {
 
 void Oled_clear()
 {
-	setColumnRange(0x00, 0x7F);
-	setPageRange(0x00, 0x07);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		uint8_t blank = 0;
-		for (int i = 0; i < 8*128; i++) {
-			spi_write_blocking(spi, &blank, 1);
-		}
+	for (int page = 0; page < NUM_PAGES; page++) {
+		blank(page, 0, NUM_COLS);
 	}
-	gpio_put(PIN_CS, 1);
+	resetFields();
 }
 
-void Oled_displayDistance(int distance_cm)
+void Oled_flush()
 {
-	if (disableStats)
+	int groupPageStart = -1;
+	int groupPageEnd = -1;
+	int groupColStart = 0;
+	int groupColEnd = 0;
+
+	// Changes stay marked dirty and go out with the next flush
+	if (Hal_spiDmaBusy(spi)) {
 		return;
+	}
+	numFlushWindows = 0;
 
-	setColumnRange(DIST_DISP_COL, 0x7F);
-	setPageRange(DIST_DISP_PAGE, DIST_DISP_PAGE);
+	for (int page = 0; page < NUM_PAGES; page++) {
+		int start = dirtyStart[page];
+		int end = dirtyEnd[page];
 
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		uint8_t space = 0;
-		if (distance_cm <= LIDAR_DC) {				// If LIDAR disconnected
-			display(letterE, 3);
-			spi_write_blocking(spi, &space, 1);
-
-			for (int i = 0; i < 2; i++) {
-				display(letterR, 3);
-				spi_write_blocking(spi, &space, 1);
+		if (start > end) {
+			continue;
+		}
+		markClean(page);
+
+		// Extend the current window down to this page if that sends fewer
+		// bytes than addressing the page on its own
+		if (groupPageStart >= 0 && page == groupPageEnd + 1) {
+			int mergedStart = start < groupColStart ? start : groupColStart;
+			int mergedEnd = end > groupColEnd ? end : groupColEnd;
+			int mergedCost = (page - groupPageStart + 1) * (mergedEnd - mergedStart + 1);
+			int separateCost = (groupPageEnd - groupPageStart + 1) * (groupColEnd - groupColStart + 1)
+					+ (end - start + 1) + WINDOW_OVERHEAD;
+
+			if (mergedCost <= separateCost) {
+				groupPageEnd = page;
+				groupColStart = mergedStart;
+				groupColEnd = mergedEnd;
+				continue;
 			}
+		}
 
-			// Erase the 'm'
-			for (int i = 0; i < 5; i++) {
-				spi_write_blocking(spi, &space, 1);
-			}
-		} else if (distance_cm == LIDAR_MAX_CM) {	// If max distance returned
-			for (int i = 2; i >= 0; i--) {
-				display(symbolNeg, 3);
-				spi_write_blocking(spi, &space, 1);
-			}
-			display(letterM, 5);
-		} else {									// Display distance
-			int distance_m = distance_cm / 100;
-			int digit[3] = {0};
-
-			digit[0] = distance_m % 10;
-			digit[1] = distance_m % 100 / 10;
-			digit[2] = distance_m % 1000 / 100;
-
-			for (int i = 2; i >= 0; i--) {
-				display(number[digit[i]], 3);
-				spi_write_blocking(spi, &space, 1);
-			}
-			display(letterM, 5);
+		if (groupPageStart >= 0) {
+			queueWindow(groupPageStart, groupPageEnd, groupColStart, groupColEnd);
 		}
+
+		groupPageStart = page;
+		groupPageEnd = page;
+		groupColStart = start;
+		groupColEnd = end;
+	}
+
+	if (groupPageStart >= 0) {
+		queueWindow(groupPageStart, groupPageEnd, groupColStart, groupColEnd);
+	}
+
+	if (numFlushWindows > 0) {
+		flushWindowIndex = 0;
+		startFlushWindow();
 	}
-	gpio_put(PIN_CS, 1);
 }
 
-void Oled_displayElevation(double angle)
+bool Oled_isFlushing()
+{
+	return Hal_spiDmaBusy(spi);
+}
+
+void Oled_waitFlush()
+{
+	// A flush is a chain of transfers, each one starts the next
+	while (Oled_isFlushing()) {
+		Hal_spiDmaWait(spi);
+	}
+}
+
+void Oled_displayDistance(int distance_cm)
 {
 	if (disableStats)
 		return;
 
-	bool negative = false;
+	char text[5];
+	int value;
 
-	if (angle < 0) {
-		negative = true;
-		angle *= -1;
+	if (distance_cm <= LIDAR_DC) {
+		value = FIELD_ERR;
+	} else if (distance_cm == LIDAR_MAX_CM) {
+		value = FIELD_MAX;
+	} else {
+		value = DIV100(distance_cm > DIV100_MAX ? DIV100_MAX : distance_cm);
 	}
-	
-	int angleInt = (int)angle;
-	int digit[3] = {0};
-
-	digit[0] = angleInt % 10;
-	digit[1] = angleInt % 100 / 10;
-	digit[2] = angleInt % 1000 / 100;
 
-	setColumnRange(0x4c, 0x7F);
-	setPageRange(0x03, 0x03);
+	if (value == lastDistance) {
+		return;
+	}
+	lastDistance = value;
 
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		uint8_t space = 0;
-
-		if (negative) {
-			display(symbolNeg, 3);
-			spi_write_blocking(spi, &space, 1);
-		} else {
-			display(symbolPlus, 3);
-			spi_write_blocking(spi, &space, 1);
-		}
-		
-		for (int i = 2; i >= 0; i--) {
-			display(number[digit[i]], 3);
-			spi_write_blocking(spi, &space, 1);
-		}
-		display(symbolDeg, 3);
+	if (value == FIELD_ERR) {				// If LIDAR disconnected
+		drawText(DIST_DISP_PAGE, DIST_DISP_COL, "ERR", DIST_DISP_WIDTH);
+	} else if (value == FIELD_MAX) {		// If max distance returned
+		drawText(DIST_DISP_PAGE, DIST_DISP_COL, "---m", DIST_DISP_WIDTH);
+	} else {								// Display distance
+		char *end = formatDigits(text, value);
+		end[0] = 'm';
+		end[1] = '\0';
+		drawText(DIST_DISP_PAGE, DIST_DISP_COL, text, DIST_DISP_WIDTH);
 	}
-	gpio_put(PIN_CS, 1);
 }
 
-void Oled_displayCant(double angle)
+void Oled_displayElevation(double angle)
 {
 	if (disableStats)
 		return;
 
-	bool negative = false;
-
-	if (angle < 0) {
-		negative = true;
-		angle *= -1;
-	}
-
-	int angleInt = (int)angle;
-	int digit[3] = {0};
-
-	digit[0] = angleInt % 10;
-	digit[1] = angleInt % 100 / 10;
-	digit[2] = angleInt % 1000 / 100;
+	displayAngle(ELEV_DISP_PAGE, ELEV_DISP_COL, angle, '+', '-', &lastElevation);
+}
 
-	setColumnRange(0x36, 0x7F);
-	setPageRange(0x01, 0x01);
+void Oled_displayCant(double angle)
+{
+	if (disableStats)
+		return;
 
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		uint8_t space = 0;
-
-		if (negative) {
-			display(letterL, 3);
-			spi_write_blocking(spi, &space, 1);
-		} else {
-			display(letterR, 3);
-			spi_write_blocking(spi, &space, 1);
-		}
-		
-		for (int i = 2; i >= 0; i--) {
-			display(number[digit[i]], 3);
-			spi_write_blocking(spi, &space, 1);
-		}
-		display(symbolDeg, 3);
-	}
-	gpio_put(PIN_CS, 1);
+	displayAngle(CANT_DISP_PAGE, CANT_DISP_COL, angle, 'R', 'L', &lastCant);
 }
 
 void Oled_displayCenter()
 {
 #if DOT_OR_CROSS == 0
-	setColumnRange(DOT_CENTER_COL, DOT_CENTER_COL);
-	setPageRange(DOT_CENTER_PAGE, DOT_CENTER_PAGE);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		uint8_t dot = 0x01;
-		spi_write_blocking(spi, &dot, 1);
-	}
-	gpio_put(PIN_CS, 1);
+	setColumn(DOT_CENTER_PAGE, DOT_CENTER_COL, 0x01);
 #elif DOT_OR_CROSS == 1
-	setColumnRange(DOT_CENTER_COL - 6, DOT_CENTER_COL + 6);
-	setPageRange(DOT_CENTER_PAGE, DOT_CENTER_PAGE);
-	
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		uint8_t sides = 0x01;
-		uint8_t center = 0x78;
-		uint8_t blank = 0x00;
+	for (int i = 0; i < 13; i++) {
+		uint8_t value = 0x00;
 
-		for (int i = 0; i < 13; i++) {
-			if (i <= 3 || i >= 9) {
-				spi_write_blocking(spi, &sides, 1);
-			} else if (i == 6) {
-				spi_write_blocking(spi, &center, 1);
-			} else {
-				spi_write_blocking(spi, &blank, 1);
-			}
+		if (i <= 3 || i >= 9) {
+			value = crossSides;
+		} else if (i == 6) {
+			value = crossCenter;
 		}
+		setColumn(DOT_CENTER_PAGE, DOT_CENTER_COL - 6 + i, value);
 	}
-	gpio_put(PIN_CS, 1);
-
-	setColumnRange(DOT_CENTER_COL, DOT_CENTER_COL);
-	setPageRange(DOT_CENTER_PAGE - 1, DOT_CENTER_PAGE - 1);
 
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		uint8_t bottom = 0x3C;
-		spi_write_blocking(spi, &bottom, 1);
-	}
-	gpio_put(PIN_CS, 1);
+	setColumn(DOT_CENTER_PAGE - 1, DOT_CENTER_COL, crossBottom);
 #endif
 }
 
 int Oled_displayCalcDot(int xOffset, int yOffset)
 {
-#if DOT_OR_CROSS == 0
-	// If current dot is on the center dot byte, redraw the center dot to clear
-	if (curCalcDotCol == DOT_CENTER_COL && curCalcDotPage == DOT_CENTER_PAGE) {
-		Oled_displayCenter();
-	} else {
-		clearCalcDot();
-	}
-#elif DOT_OR_CROSS == 1
-	clearCalcDot();
-#endif
-	uint8_t pixel = 0;
-
-	if (xOffset < -16 || xOffset >= 16) {
-		// Out of range
-		curCalcDotCol = DOT_CENTER_COL;
-		curCalcDotPage = DOT_CENTER_PAGE;
-#if DOT_OR_CROSS == 1
-		Oled_displayCenter();
-#endif
-		return OLED_OFF_SCREEN;
-	}
+	return moveCalcDot(xOffset, yOffset, 1, 1);
+}
 
-	if (yOffset < -24 || yOffset >= 16) {
-		// Out of range
-		curCalcDotCol = DOT_CENTER_COL;
-		curCalcDotPage = DOT_CENTER_PAGE;
-#if DOT_OR_CROSS == 1
-		Oled_displayCenter();
+int Oled_displayReticle(int32_t xOffset_q8, int32_t yOffset_q8)
+{
+	int x, y, width, height;
+#if RETICLE_DITHER == 1
+	int threshold = ditherThresholds[ditherFrame++ & (RETICLE_DITHER_FRAMES - 1)];
+#else
+	int threshold = RETICLE_HALF_Q8 / 2;
 #endif
-		return OLED_OFF_SCREEN;
-	}
-
-	curCalcDotCol = DOT_CENTER_COL + xOffset;
 
-	curCalcDotPage = (yOffset + DOT_CENTER_PAGE * 8) / 8;
-	pixel = 0x01 << ((yOffset + DOT_CENTER_PAGE * 8) % 8);
-#if DOT_OR_CROSS == 0
-	// If pixel is on the center dot byte, add the center dot too
-	if (curCalcDotCol == DOT_CENTER_COL && curCalcDotPage == DOT_CENTER_PAGE) {
-		pixel |= 0x01;
-	}
-
-	setColumnRange(curCalcDotCol, curCalcDotCol);
-	setPageRange(curCalcDotPage, curCalcDotPage);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		spi_write_blocking(spi, &pixel, 1);
-	}
-	gpio_put(PIN_CS, 1);
-#elif DOT_OR_CROSS == 1
-	// If inside of crosshair
-	if (abs(xOffset) <= 9 && abs(yOffset) <= 9) {
-		uint8_t blank = 0;
-
-		// Draw part of crosshair
-		setColumnRange(DOT_CENTER_COL - 6, DOT_CENTER_COL + 6);
-		setPageRange(DOT_CENTER_PAGE, DOT_CENTER_PAGE);
-
-		gpio_put(PIN_DC, OLED_DC_DATA);
-		gpio_put(PIN_CS, 0);
-		{
-			uint8_t sides = 0x01;
-			uint8_t center = 0x78;
-			uint8_t blank = 0x00;
-
-			for (int i = 0; i < 13; i++) {
-				if (i <= 3 && xOffset >= 0) {
-					spi_write_blocking(spi, &sides, 1);
-				} else if (i >= 9 && xOffset <= 0) {
-					spi_write_blocking(spi, &sides, 1);
-				} else if (i == 6 && yOffset <= 0) {
-					spi_write_blocking(spi, &center, 1);
-				} else {
-					spi_write_blocking(spi, &blank, 1);
-				}
-			}
-		}
-		gpio_put(PIN_CS, 1);
-
-		if (yOffset >= 0) {
-			setColumnRange(DOT_CENTER_COL, DOT_CENTER_COL);
-			setPageRange(DOT_CENTER_PAGE - 1, DOT_CENTER_PAGE - 1);
-
-			gpio_put(PIN_DC, OLED_DC_DATA);
-			gpio_put(PIN_CS, 0);
-			{
-				uint8_t bottom = 0x3C;
-				spi_write_blocking(spi, &bottom, 1);
-			}
-			gpio_put(PIN_CS, 1);
-		}
-	} else {
-		Oled_displayCenter();
-	}
-
-	// If pixel is on the center dot byte, add the center dot too
-	if (xOffset == 0 && yOffset == 0) {
-		pixel |= 0x78;
-	}
-
-	setColumnRange(curCalcDotCol, curCalcDotCol);
-	setPageRange(curCalcDotPage, curCalcDotPage);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		spi_write_blocking(spi, &pixel, 1);
-	}
-	gpio_put(PIN_CS, 1);
-
-	return OLED_SUCCESS;
-#endif
-	return OLED_SUCCESS;
+	placeReticle(xOffset_q8, threshold, &x, &width);
+	placeReticle(yOffset_q8, threshold, &y, &height);
+	return moveCalcDot(x, y, width, height);
 }
 
 void Oled_displayLock()
 {
-	setColumnRange(DIST_DISP_COL - 6, DIST_DISP_COL);
-	setPageRange(DIST_DISP_PAGE, DIST_DISP_PAGE);
+	static const char lock[] = {CHAR_LOCK, '\0'};
 
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		display(symbolLock, 5);
+	if (lastLock == 1) {
+		return;
 	}
-	gpio_put(PIN_CS, 1);
+	lastLock = 1;
+	drawText(DIST_DISP_PAGE, LOCK_DISP_COL, lock, LOCK_DISP_WIDTH);
 }
 
 void Oled_clearLock()
 {
-	setColumnRange(DIST_DISP_COL - 6, DIST_DISP_COL);
-	setPageRange(DIST_DISP_PAGE, DIST_DISP_PAGE);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		u_int8_t blank = 0x00;
-		for (int i = 0; i < 5; i++) {
-			spi_write_blocking(spi, &blank, 1);
-		}
+	if (lastLock == 0) {
+		return;
 	}
-	gpio_put(PIN_CS, 1);
+	lastLock = 0;
+	blank(DIST_DISP_PAGE, LOCK_DISP_COL, LOCK_DISP_WIDTH);
 }
 
 void Oled_displayCalcDotErr()
 {
-	setColumnRange(0x20, 0x20);
-	setPageRange(0x02, 0x02);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		u_int8_t error = 0xE4;
-		spi_write_blocking(spi, &error, 1);
-	}
-	gpio_put(PIN_CS, 1);
+	setColumn(DOT_ERR_PAGE, DOT_ERR_COL, 0xE4);
 }
 
 void Oled_clearCalcDotErr()
 {
-	setColumnRange(0x20, 0x20);
-	setPageRange(0x02, 0x02);
-
-	gpio_put(PIN_DC, OLED_DC_DATA);
-	gpio_put(PIN_CS, 0);
-	{
-		u_int8_t blank = 0x00;
-		spi_write_blocking(spi, &blank, 1);
-	}
-	gpio_put(PIN_CS, 1);
+	setColumn(DOT_ERR_PAGE, DOT_ERR_COL, 0x00);
 }
@@ -3,13 +3,20 @@
 / ---------------------------------------------------------------------------- /
 /	Bowie Gian
 /	Created: 2023-06-30
-/	Modified: 2023-07-28
+/	Modified: 2026-10-17
 /
 /	This file contains the function declarations for operating the OLED screen.
+/	The display functions draw into a frame buffer, nothing reaches the
+/	screen until Oled_flush() is called. Each one remembers what it drew
+/	and returns straight away when called with the same value again, until
+/	Oled_clear() wipes the screen.
 / ----------------------------------------------------------------------------*/
 #ifndef OLED_H
 #define OLED_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /*--------------------------------------------------------------*/
 /* Definitions													*/
 /*--------------------------------------------------------------*/
@@ -29,6 +36,17 @@ void Oled_brightnessPoll();
 // Turns off all pixels
 void Oled_clear();
 
+// Starts sending the columns that changed since the last flush to the OLED
+// Returns straight away, the transfer runs on DMA. If the previous flush is
+// still in progress the changes are kept for the next call.
+void Oled_flush();
+
+// Returns true while a flush is being sent
+bool Oled_isFlushing();
+
+// Blocks until the flush in progress has reached the screen
+void Oled_waitFlush();
+
 // Displays the distance in meters at the top
 // If distance_cm is -1, displays ERR at the top
 // If distance_cm is 18000, displays ---m at the top
@@ -44,9 +62,16 @@ void Oled_displayCant(double angle);
 void Oled_displayCenter();
 
 // Display a dot offset down from the center dot
+// It can go anywhere on the panel except over the text (AIM_EXTENDED)
 // Returns 0 on success, -1 on failure (off screen)
 int Oled_displayCalcDot(int x, int y);
 
+// Same as Oled_displayCalcDot, with offsets in Q8 (1/256 pixel)
+// The dot is 1 or 2 pixels each way, so it can sit half way between
+// pixels, and finer steps are dithered over a few frames
+// Returns 0 on success, -1 on failure (off screen)
+int Oled_displayReticle(int32_t xOffset_q8, int32_t yOffset_q8);
+
 void Oled_displayLock();
 
 void Oled_clearLock();
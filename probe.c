@@ -0,0 +1,128 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - probe.c															   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the timing probe statistics.
+/
+/	A probe reads SysTick, which counts processor cycles on whichever core
+/	it runs on, so the two cores can time their own stages. The histogram
+/	has a bucket per power of 2 cycles, which is a count of leading zeros
+/	on the hot path and no division. Everything is converted to
+/	microseconds only when the report is printed. The report reads
+/	counters core 1 may be writing, so a line can be one run out.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "probe.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// Bucket n holds runs of 2^(n-1) to 2^n - 1 cycles, HAL_CYCLE_MASK is 24 bits
+#define NUM_BUCKETS 25
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	uint32_t runs;
+	uint32_t minCycles;
+	uint32_t maxCycles;
+	uint64_t sumCycles;
+	uint32_t buckets[NUM_BUCKETS];
+} ProbeStats;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static const char *names[PROBE_NUM_STAGES] = {
+	"accel",
+	"lidar",
+	"ballistics",
+	"oled lock",
+	"oled dist",
+	"oled elev",
+	"oled cant",
+	"oled dot",
+	"oled flush",
+};
+
+static ProbeStats stats[PROBE_NUM_STAGES];
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+// Prints cycles as microseconds with one decimal
+static void printUs(const char *label, uint64_t cycles, uint32_t cyclesPerUs)
+{
+	uint64_t tenths = cycles * 10 / cyclesPerUs;
+
+	printf(" %s %lu.%lu us", label, (unsigned long)(tenths / 10),
+			(unsigned long)(tenths % 10));
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Probe_add(ProbeStage stage, uint32_t cycles)
+{
+	ProbeStats *probe = &stats[stage];
+	int bucket = cycles == 0 ? 0 : 32 - __builtin_clz(cycles);
+
+	if (probe->runs == 0 || cycles < probe->minCycles)
+		probe->minCycles = cycles;
+	if (cycles > probe->maxCycles)
+		probe->maxCycles = cycles;
+	probe->sumCycles += cycles;
+	probe->buckets[bucket]++;
+	probe->runs++;
+}
+
+void Probe_report()
+{
+#if PROBE == 1
+	uint32_t cyclesPerUs = Hal_cyclesPerUs();
+
+	for (int i = 0; i < PROBE_NUM_STAGES; i++) {
+		ProbeStats *probe = &stats[i];
+
+		if (probe->runs == 0) {
+			continue;
+		}
+
+		printf("%-10s runs %lu", names[i], (unsigned long)probe->runs);
+		printUs("min", probe->minCycles, cyclesPerUs);
+		printUs("mean", probe->sumCycles / probe->runs, cyclesPerUs);
+		printUs("max", probe->maxCycles, cyclesPerUs);
+		printf("\r\n          ");
+
+		// Runs under each power of 2 cycles
+		for (int j = 0; j < NUM_BUCKETS; j++) {
+			if (probe->buckets[j] > 0) {
+				printUs("<", (uint64_t)1 << j, cyclesPerUs);
+				printf(" %lu", (unsigned long)probe->buckets[j]);
+			}
+			probe->buckets[j] = 0;
+		}
+		printf("\r\n");
+
+		probe->runs = 0;
+		probe->maxCycles = 0;
+		probe->sumCycles = 0;
+	}
+#else
+	printf("timing probes compiled out\r\n");
+#endif
+}
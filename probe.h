@@ -0,0 +1,58 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - probe.h															   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the timing probes. PROBE_BEGIN and PROBE_END around
+/	a stage count the CPU cycles it took (host nanoseconds in the
+/	simulation) into its minimum, maximum, mean and a histogram. With
+/	PROBE set to 0 they compile to nothing.
+/ ----------------------------------------------------------------------------*/
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdint.h>
+#include "hal.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// 1 times the stages, 0 compiles the probes out
+#define PROBE 1
+
+// Each stage is only timed on one core
+typedef enum {
+	PROBE_ACCEL_POLL,			// Core 0
+	PROBE_LIDAR_POLL,
+	PROBE_BALLISTICS,
+	PROBE_OLED_LOCK,			// Core 1
+	PROBE_OLED_DISTANCE,
+	PROBE_OLED_ELEVATION,
+	PROBE_OLED_CANT,
+	PROBE_OLED_DOT,
+	PROBE_OLED_FLUSH,
+	PROBE_NUM_STAGES
+} ProbeStage;
+
+#if PROBE == 1
+#define PROBE_BEGIN(stage) uint32_t stage##_start = Hal_cycleCount()
+#define PROBE_END(stage) Probe_add(stage, (Hal_cycleCount() - stage##_start) & HAL_CYCLE_MASK)
+#else
+#define PROBE_BEGIN(stage)
+#define PROBE_END(stage)
+#endif
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Counts one run of a stage, use PROBE_END rather than calling it
+void Probe_add(ProbeStage stage, uint32_t cycles);
+
+// Prints every stage that ran since the last report, then starts over
+void Probe_report();
+
+#endif
@@ -0,0 +1,253 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - profile.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the functions that load and store the ammunition and
+/	optic profiles.
+/
+/	The sector holds a header, every profile and a CRC-32. It is copied to
+/	RAM once at boot so the ballistics never read through the XIP cache,
+/	and rewritten in full once a profile or the selection has stopped
+/	changing for SAVE_DELAY_US (Profile_poll). Writing the sector erases it
+/	with interrupts off and core 1 locked out, which stalls the display and
+/	the LIDAR UART for tens of ms, so stepping through the profiles costs
+/	one write instead of one per step.
+/	A profile with a load or optic the ballistics can't work with is
+/	refused by Profile_store() and replaced by the defaults on load, a
+/	valid CRC only means the sector was written, not what with.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "profile.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define PROFILE_MAGIC 0x424F4649		// "IFOB"
+#define PROFILE_VERSION 1
+
+#define SAVE_DELAY_US 2000000
+
+// What the drag solver and the screen scaling can take
+#define MIN_MUZZLE_VELOCITY 50.0f		// m/s
+#define MAX_MUZZLE_VELOCITY 1500.0f
+#define MAX_BALLISTIC_COEFFICIENT 2.0f	// lb/in^2
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t activeIndex;
+	Profile profiles[PROFILE_COUNT];
+	uint32_t crc;					// Over everything above
+} ProfileSector;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+// v_muzzle, ballisticCoefficient and elevBias_rad will need to be tweaked
+// during testing
+static const Profile defaultProfile = {
+	.name = "default",
+	.load = {
+		.muzzleVelocity = 390,
+		.ballisticCoefficient = 0.125f,
+		.dragModel = DRAG_G1
+	},
+	.elevBias_rad = 0.012f,
+	.pixelWidth_m = 0.000254f,
+	.eyeToOptic_m = 0.05f,
+	.heightOverBore_m = 0.06f
+};
+
+static ProfileSector sector;
+static bool isLoaded = false;
+static bool isChanged = false;
+static bool isDirty = false;		// RAM copy not in flash yet
+static uint64_t dirtyUs;			// Last change
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static uint32_t crc32(const uint8_t *data, size_t len)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < len; i++) {
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+
+	return ~crc;
+}
+
+static uint32_t sectorCrc(const ProfileSector *s)
+{
+	return crc32((const uint8_t *)s, offsetof(ProfileSector, crc));
+}
+
+// Also false for NaN, every compare with it fails
+static bool isValid(const Profile *profile)
+{
+	const AmmoLoad *load = &profile->load;
+
+	return load->muzzleVelocity >= MIN_MUZZLE_VELOCITY
+			&& load->muzzleVelocity <= MAX_MUZZLE_VELOCITY
+			&& load->ballisticCoefficient >= 0
+			&& load->ballisticCoefficient <= MAX_BALLISTIC_COEFFICIENT
+			&& (load->dragModel == DRAG_G1 || load->dragModel == DRAG_G7)
+			&& profile->pixelWidth_m > 0 && profile->eyeToOptic_m > 0
+			&& profile->elevBias_rad == profile->elevBias_rad
+			&& profile->heightOverBore_m == profile->heightOverBore_m;
+}
+
+static void loadDefaults()
+{
+	memset(&sector, 0, sizeof(sector));
+	sector.magic = PROFILE_MAGIC;
+	sector.version = PROFILE_VERSION;
+	sector.activeIndex = 0;
+
+	for (int i = 0; i < PROFILE_COUNT; i++) {
+		sector.profiles[i] = defaultProfile;
+	}
+}
+
+static void save()
+{
+	sector.crc = sectorCrc(&sector);
+	Hal_flashWriteSector((const uint8_t *)&sector, sizeof(sector));
+	isDirty = false;
+}
+
+// Queues the sector to be written once it stops changing
+static void markDirty()
+{
+	isDirty = true;
+	dirtyUs = Hal_timeUs();
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Profile_setup()
+{
+	memcpy(&sector, Hal_flashSector(), sizeof(sector));
+
+	if (sector.magic != PROFILE_MAGIC || sector.version != PROFILE_VERSION
+			|| sector.crc != sectorCrc(&sector) || sector.activeIndex >= PROFILE_COUNT) {
+		printf("Profiles not found, using defaults\r\n");
+		loadDefaults();
+	}
+
+	for (int i = 0; i < PROFILE_COUNT; i++) {
+		if (!isValid(&sector.profiles[i])) {
+			printf("Profile %d is invalid, using the default\r\n", i);
+			sector.profiles[i] = defaultProfile;
+		}
+	}
+
+	isLoaded = true;
+	isChanged = false;
+	printf("Profile %d: %s\r\n", sector.activeIndex, sector.profiles[sector.activeIndex].name);
+}
+
+const Profile *Profile_getActive()
+{
+	if (!isLoaded) {
+		return &defaultProfile;
+	}
+	return &sector.profiles[sector.activeIndex];
+}
+
+int Profile_getActiveIndex()
+{
+	return isLoaded ? sector.activeIndex : 0;
+}
+
+const Profile *Profile_get(int index)
+{
+	if (index < 0 || index >= PROFILE_COUNT) {
+		return NULL;
+	}
+	return isLoaded ? &sector.profiles[index] : &defaultProfile;
+}
+
+bool Profile_select(int index)
+{
+	if (index < 0 || index >= PROFILE_COUNT) {
+		return false;
+	}
+	if (!isLoaded) {
+		loadDefaults();
+		isLoaded = true;
+	}
+
+	if (index != sector.activeIndex) {
+		sector.activeIndex = (uint16_t)index;
+		isChanged = true;
+		markDirty();
+	}
+
+	return true;
+}
+
+bool Profile_store(int index, const Profile *profile)
+{
+	if (index < 0 || index >= PROFILE_COUNT || !isValid(profile)) {
+		return false;
+	}
+	if (!isLoaded) {
+		loadDefaults();
+		isLoaded = true;
+	}
+
+	sector.profiles[index] = *profile;
+	sector.profiles[index].name[PROFILE_NAME_LEN - 1] = '\0';
+	if (index == sector.activeIndex) {
+		isChanged = true;
+	}
+	markDirty();
+
+	return true;
+}
+
+void Profile_poll()
+{
+	if (isDirty && Hal_timeUs() - dirtyUs >= SAVE_DELAY_US) {
+		save();
+	}
+}
+
+void Profile_flush()
+{
+	if (isDirty) {
+		save();
+	}
+}
+
+bool Profile_isChanged()
+{
+	bool wasChanged = isChanged;
+	isChanged = false;
+	return wasChanged;
+}
@@ -0,0 +1,70 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - profile.h														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the ammunition and
+/	optic profiles. The profiles and the active selection are kept in the
+/	reserved settings flash sector, so a new rifle setup doesn't need a
+/	reflash.
+/ ----------------------------------------------------------------------------*/
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include "trajectory.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define PROFILE_COUNT 4
+#define PROFILE_NAME_LEN 12
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+// Stored as is in flash, bump PROFILE_VERSION in profile.c on any change
+typedef struct {
+	char name[PROFILE_NAME_LEN];
+	AmmoLoad load;
+	float elevBias_rad;			// angle between muzzle and red dot
+	float pixelWidth_m;			// OLED pixel pitch
+	float eyeToOptic_m;
+	float heightOverBore_m;
+} Profile;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Loads the profiles from flash, or the built in defaults if the sector is
+// blank or corrupt
+void Profile_setup();
+
+// Profile in use, the defaults until Profile_setup() is called
+const Profile *Profile_getActive();
+int Profile_getActiveIndex();
+const Profile *Profile_get(int index);
+
+// Selects and stores a profile, the flash sector is written by
+// Profile_poll() once they stop changing
+// Returns false for an index out of range, or a profile with a muzzle
+// velocity, ballistic coefficient or optic the ballistics can't use
+bool Profile_select(int index);
+bool Profile_store(int index, const Profile *profile);
+
+// Call periodically, writes the flash sector 2 s after the last
+// change, one write for any number of changes
+void Profile_poll();
+
+// Writes the flash sector now if it has changes
+void Profile_flush();
+
+// True once after the active profile has changed
+bool Profile_isChanged();
+
+#endif
@@ -0,0 +1,215 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - rangefilter.c													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the LIDAR range filter.
+/
+/	The TF-series reports an unreliable distance when the return strength
+/	is under 100 or saturated at 65535, so those frames never reach the
+/	window. For the rest the median of the last RANGE_WINDOW distances and
+/	their median absolute deviation (MAD) are worked out every frame. A
+/	distance more than 4.5 MADs (3 standard deviations) from the median,
+/	and more than the sensor's own error, is an outlier and the median
+/	stands in for it. The result goes through an exponential average that
+/	snaps to a new distance once the median has moved there and
+/	SNAP_FRAMES frames have read it, so a change of target isn't smeared
+/	over the average while a burst of bad returns that tips the median for
+/	a frame doesn't move it at all.
+/	The window is 5 long, so the sorting is a handful of compares.
+/
+/	The radial velocity is the change of the smoothed range over at least
+/	RATE_BASELINE_US, averaged again. Over a shorter time the sensor's few
+/	cm of noise would swamp a walking target, and the average of a steady
+/	ramp moves at the ramp's own speed, so the smoothing doesn't bias it.
+/	It starts over from 0 when the range snaps to a new target or the
+/	frames stop for longer than RATE_MAX_GAP_US.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include "rangefilter.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define MIN_STRENGTH 100
+#define SATURATED_STRENGTH 65535
+
+// Outliers are more than HAMPEL_MADS_X2 / 2 MADs off the median
+#define HAMPEL_MADS_X2 9
+
+// Sensor error, 6 cm up to 6 m then 1 %, doubled
+#define MIN_SPREAD_CM 12
+#define MIN_SPREAD_DIVISOR 50
+
+// Exponential average weight of a new distance, 1 / 2^SMOOTH_SHIFT
+#define SMOOTH_SHIFT 2
+#define SNAP_FRAMES 2
+
+// Radial velocity baseline and average weight, 1 / 2^RATE_SMOOTH_SHIFT
+#define RATE_BASELINE_US 200000
+#define RATE_MAX_GAP_US 1000000
+#define RATE_SMOOTH_SHIFT 2
+#define RATE_MAX_CMS 10000
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static void sortWindow(short values[], int count)
+{
+	for (int i = 1; i < count; i++) {
+		short value = values[i];
+		int j = i;
+
+		while (j > 0 && values[j - 1] > value) {
+			values[j] = values[j - 1];
+			j--;
+		}
+		values[j] = value;
+	}
+}
+
+static short median(short values[], int count)
+{
+	sortWindow(values, count);
+	return values[count / 2];
+}
+
+static void addHistory(RangeFilter *filter, bool isGood)
+{
+	filter->history = (uint8_t)((filter->history << 1) | (isGood ? 1 : 0));
+}
+
+static void restartRate(RangeFilter *filter, uint32_t timeUs)
+{
+	filter->rateStart = filter->smoothed;
+	filter->rateStartUs = timeUs;
+	filter->velocity = 0;
+}
+
+// Once the baseline has passed, folds its slope into the velocity
+static void updateRate(RangeFilter *filter, uint32_t timeUs)
+{
+	uint32_t elapsedUs = timeUs - filter->rateStartUs;
+
+	if (elapsedUs > RATE_MAX_GAP_US) {
+		restartRate(filter, timeUs);
+		return;
+	}
+	if (elapsedUs < RATE_BASELINE_US) {
+		return;
+	}
+
+	// smoothed is in 1/16 cm
+	int32_t velocity = (int32_t)((int64_t)(filter->smoothed - filter->rateStart)
+			* (1000000 / 16) / (int64_t)elapsedUs);
+	if (velocity > RATE_MAX_CMS)
+		velocity = RATE_MAX_CMS;
+	if (velocity < -RATE_MAX_CMS)
+		velocity = -RATE_MAX_CMS;
+
+	filter->velocity += (velocity - filter->velocity) / (1 << RATE_SMOOTH_SHIFT);
+	filter->rateStart = filter->smoothed;
+	filter->rateStartUs = timeUs;
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void RangeFilter_init(RangeFilter *filter)
+{
+	filter->index = 0;
+	filter->count = 0;
+	filter->smoothed = 0;
+	filter->numFar = 0;
+	filter->history = 0;
+	filter->numWeak = 0;
+	filter->numOutliers = 0;
+	filter->rateStart = 0;
+	filter->rateStartUs = 0;
+	filter->velocity = 0;
+}
+
+bool RangeFilter_addFrame(RangeFilter *filter, short distance_cm, unsigned short strength,
+		uint32_t timeUs)
+{
+	short sorted[RANGE_WINDOW];
+	short deviation[RANGE_WINDOW];
+
+	if (strength < MIN_STRENGTH || strength == SATURATED_STRENGTH || distance_cm <= 0) {
+		filter->numWeak++;
+		addHistory(filter, false);
+		return false;
+	}
+
+	filter->window[filter->index] = distance_cm;
+	filter->index = (filter->index + 1) % RANGE_WINDOW;
+	if (filter->count < RANGE_WINDOW) {
+		filter->count++;
+	}
+
+	for (int i = 0; i < filter->count; i++) {
+		sorted[i] = filter->window[i];
+	}
+	short middle = median(sorted, filter->count);
+
+	for (int i = 0; i < filter->count; i++) {
+		int difference = sorted[i] - middle;
+		deviation[i] = (short)(difference < 0 ? -difference : difference);
+	}
+	int mad = median(deviation, filter->count);
+
+	int spread = (HAMPEL_MADS_X2 * mad) / 2;
+	int minSpread = MIN_SPREAD_CM + middle / MIN_SPREAD_DIVISOR;
+	if (spread < minSpread)
+		spread = minSpread;
+
+	int offset = distance_cm - middle;
+	bool isOutlier = offset > spread || offset < -spread;
+	short value = isOutlier ? middle : distance_cm;
+
+	if (isOutlier) {
+		filter->numOutliers++;
+	}
+	addHistory(filter, !isOutlier);
+
+	// The first frame, or a new target
+	int32_t target = (int32_t)value * 16;
+	int32_t step = target - filter->smoothed;
+	if (step <= spread * 16 && step >= -spread * 16) {
+		filter->numFar = 0;
+		filter->smoothed += step / (1 << SMOOTH_SHIFT);
+		updateRate(filter, timeUs);
+	} else if (filter->count == 1 || (!isOutlier && ++filter->numFar >= SNAP_FRAMES)) {
+		filter->numFar = 0;
+		filter->smoothed = target;
+		restartRate(filter, timeUs);
+	}
+
+	return !isOutlier;
+}
+
+Range RangeFilter_get(const RangeFilter *filter)
+{
+	Range range = {0, 0, 0};
+	int numGood = 0;
+
+	for (int i = 0; i < 8; i++) {
+		numGood += (filter->history >> i) & 1;
+	}
+
+	if (filter->count > 0) {
+		range.distance_cm = (short)((filter->smoothed + 8) / 16);
+		range.confidence = (uint8_t)(numGood * 100 / 8);
+		range.velocity_cms = (short)filter->velocity;
+	}
+	return range;
+}
@@ -0,0 +1,65 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - rangefilter.h													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the LIDAR range
+/	filter. Frames with too weak or a saturated return are dropped, a
+/	distance that is far from the median of the last few is taken as an
+/	outlier and replaced by that median (a Hampel filter), and what is left
+/	is smoothed. The cost per frame is the same whatever the frames are.
+/	The change of the smoothed range over time gives the radial velocity.
+/ ----------------------------------------------------------------------------*/
+#ifndef RANGEFILTER_H
+#define RANGEFILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define RANGE_WINDOW 5
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	short distance_cm;
+	uint8_t confidence;			// 0 - 100 %, good frames among the last 8
+	short velocity_cms;			// Moving away in cm/s, negative closing
+} Range;
+
+typedef struct {
+	short window[RANGE_WINDOW];	// Last distances that passed the strength gate
+	int index;
+	int count;
+	int32_t smoothed;			// 1/16 cm
+	int numFar;					// Frames in a row far from smoothed
+	uint8_t history;			// One bit per frame, 1 for a good one
+	int32_t rateStart;			// smoothed at rateStartUs
+	uint32_t rateStartUs;
+	int32_t velocity;			// cm/s
+	uint32_t numWeak;
+	uint32_t numOutliers;
+} RangeFilter;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+void RangeFilter_init(RangeFilter *filter);
+
+// Adds a frame's distance and signal strength, and when it arrived
+// Returns false if the frame was dropped or taken as an outlier
+bool RangeFilter_addFrame(RangeFilter *filter, short distance_cm, unsigned short strength,
+		uint32_t timeUs);
+
+// The filtered range, a confidence of 0 before the first good frame
+Range RangeFilter_get(const RangeFilter *filter);
+
+#endif
@@ -0,0 +1,195 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - scheduler.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the cooperative deadline scheduler.
+/
+/	Periodic releases sit on a fixed grid (first release + n * period), so
+/	the period doesn't drift with how long the tasks take. When nothing is
+/	released the core sleeps until the earliest next release. A task that
+/	is still waiting when its following release comes round loses that
+/	release, which counts as an overrun like a missed deadline does.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "hal.h"
+#include "scheduler.h"
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	void (*run)(void);
+	uint32_t periodUs;
+	uint32_t deadlineUs;
+	uint64_t releaseUs;				// Next periodic release
+	volatile bool isReleased;		// Set by Scheduler_release()
+	volatile uint32_t eventUs;		// Low bits of the time it was released
+	TaskStats stats;
+} Task;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static Task tasks[SCHEDULER_MAX_TASKS];
+static int numTasks = 0;
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+// Earliest release of a task that is due at nowUs
+static uint64_t releaseTime(const Task *task, uint64_t nowUs)
+{
+	uint64_t releaseUs = task->releaseUs;
+
+	if (task->isReleased) {
+		uint64_t eventUs = nowUs - (uint32_t)((uint32_t)nowUs - task->eventUs);
+		if (eventUs < releaseUs)
+			releaseUs = eventUs;
+	}
+	return releaseUs;
+}
+
+// Released task with the earliest deadline, -1 if none
+static int nextTask(uint64_t nowUs)
+{
+	int next = -1;
+	uint64_t nextDeadlineUs = UINT64_MAX;
+
+	for (int i = 0; i < numTasks; i++) {
+		Task *task = &tasks[i];
+
+		if (!task->isReleased && task->releaseUs > nowUs) {
+			continue;
+		}
+
+		uint64_t deadlineUs = releaseTime(task, nowUs) + task->deadlineUs;
+		if (deadlineUs < nextDeadlineUs) {
+			next = i;
+			nextDeadlineUs = deadlineUs;
+		}
+	}
+
+	return next;
+}
+
+static void runTask(Task *task, uint64_t startUs)
+{
+	uint64_t releaseUs = releaseTime(task, startUs);
+	bool isEvent = task->isReleased;
+
+	// Cleared first so a release during the run isn't lost
+	task->isReleased = false;
+	task->run();
+
+	uint64_t endUs = Hal_timeUs();
+	uint32_t runUs = (uint32_t)(endUs - startUs);
+	uint32_t lateUs = (uint32_t)(startUs - releaseUs);
+
+	task->stats.runs++;
+	task->stats.lastRunUs = runUs;
+	if (runUs > task->stats.maxRunUs)
+		task->stats.maxRunUs = runUs;
+	if (lateUs > task->stats.maxLateUs)
+		task->stats.maxLateUs = lateUs;
+	if (endUs > releaseUs + task->deadlineUs) {
+		task->stats.overruns++;
+	}
+
+	if (isEvent) {
+		task->releaseUs = startUs + task->periodUs;
+	} else {
+		task->releaseUs += task->periodUs;
+		while (task->releaseUs + task->periodUs <= endUs) {
+			task->releaseUs += task->periodUs;
+			task->stats.overruns++;
+		}
+	}
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+int Scheduler_addTask(const char *name, void (*run)(void), uint32_t periodUs,
+		uint32_t deadlineUs)
+{
+	if (numTasks >= SCHEDULER_MAX_TASKS) {
+		return -1;
+	}
+
+	Task *task = &tasks[numTasks];
+	task->run = run;
+	task->periodUs = periodUs;
+	task->deadlineUs = deadlineUs;
+	task->releaseUs = Hal_timeUs() + periodUs;
+	task->isReleased = false;
+	task->stats = (TaskStats){.name = name};
+
+	return numTasks++;
+}
+
+void Scheduler_release(int id)
+{
+	if (id < 0 || id >= numTasks) {
+		return;
+	}
+
+	tasks[id].eventUs = (uint32_t)Hal_timeUs();
+	tasks[id].isReleased = true;
+}
+
+void Scheduler_runUntil(uint64_t endUs)
+{
+	while (true) {
+		uint64_t nowUs = Hal_timeUs();
+		int next = nextTask(nowUs);
+
+		if (next >= 0) {
+			runTask(&tasks[next], nowUs);
+			continue;
+		}
+
+		if (nowUs >= endUs) {
+			return;
+		}
+
+		uint64_t wakeUs = endUs;
+		for (int i = 0; i < numTasks; i++) {
+			if (tasks[i].releaseUs < wakeUs)
+				wakeUs = tasks[i].releaseUs;
+		}
+		Hal_sleepUntilUs(wakeUs);
+	}
+}
+
+TaskStats Scheduler_getStats(int id)
+{
+	if (id < 0 || id >= numTasks) {
+		return (TaskStats){0};
+	}
+	return tasks[id].stats;
+}
+
+void Scheduler_report()
+{
+	for (int i = 0; i < numTasks; i++) {
+		const TaskStats *stats = &tasks[i].stats;
+
+		printf("%-8s runs %lu, overruns %lu, max run %lu us, max late %lu us\r\n",
+				stats->name, (unsigned long)stats->runs,
+				(unsigned long)stats->overruns, (unsigned long)stats->maxRunUs,
+				(unsigned long)stats->maxLateUs);
+	}
+}
@@ -0,0 +1,59 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - scheduler.h														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the cooperative task
+/	scheduler. Tasks are released at absolute times from their period, or
+/	early by an interrupt, and always run to completion. The released task
+/	with the earliest deadline runs first.
+/ ----------------------------------------------------------------------------*/
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define SCHEDULER_MAX_TASKS 8
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	const char *name;
+	uint32_t runs;
+	uint32_t overruns;		// Finished past the deadline or missed a release
+	uint32_t maxRunUs;		// Longest run
+	uint32_t lastRunUs;		// Latest run
+	uint32_t maxLateUs;		// Longest wait from release to start
+} TaskStats;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Adds a task released every periodUs, the first release is one period away
+// It must finish within deadlineUs of its release
+// Returns the task id, or -1 when the table is full
+int Scheduler_addTask(const char *name, void (*run)(void), uint32_t periodUs,
+		uint32_t deadlineUs);
+
+// Releases a task now, safe to call from an interrupt
+// Its next periodic release is then one period after it runs
+void Scheduler_release(int id);
+
+// Runs released tasks and sleeps in between until endUs (Hal_timeUs())
+void Scheduler_runUntil(uint64_t endUs);
+
+TaskStats Scheduler_getStats(int id);
+
+// Prints the statistics of every task
+void Scheduler_report();
+
+#endif
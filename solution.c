@@ -0,0 +1,82 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - solution.c														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the lock free double buffer for the solution record.
+/
+/	The writer alternates between two slots, so it never touches the slot
+/	holding the newest solution. Each slot has a sequence count that is odd
+/	while it is being written. The reader copies the newest slot and checks
+/	that the count didn't change, which only fails if the writer published
+/	twice during the copy, and then simply tries the newer one.
+/	The M0+ has no atomic read-modify-write between cores, so only plain
+/	loads, stores and barriers are used.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include "solution.h"
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	uint32_t count;			// 2n once solution n is complete, odd mid write
+	Solution solution;
+} Slot;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static Slot slots[2];
+static uint32_t latest = 0;		// Sequence number of the newest solution
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+void Solution_publish(const Solution *solution)
+{
+	uint32_t sequence = latest + 1;
+	Slot *slot = &slots[sequence & 1];
+
+	__atomic_store_n(&slot->count, 2 * sequence - 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	slot->solution = *solution;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	__atomic_store_n(&slot->count, 2 * sequence, __ATOMIC_RELAXED);
+	__atomic_store_n(&latest, sequence, __ATOMIC_RELEASE);
+}
+
+uint32_t Solution_read(Solution *solution)
+{
+	while (true) {
+		uint32_t sequence = __atomic_load_n(&latest, __ATOMIC_ACQUIRE);
+		const Slot *slot = &slots[sequence & 1];
+
+		if (sequence == 0) {
+			return 0;
+		}
+
+		uint32_t before = __atomic_load_n(&slot->count, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+		*solution = slot->solution;
+
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		uint32_t after = __atomic_load_n(&slot->count, __ATOMIC_RELAXED);
+
+		if (before == 2 * sequence && after == before) {
+			return sequence;
+		}
+	}
+}
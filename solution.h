@@ -0,0 +1,47 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - solution.h														   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the solution record,
+/	everything the display needs from one frame of sensor readings and
+/	ballistics. Core 0 publishes it and core 1 reads it without locks.
+/	The ballistics are solved once per frame into it, anything else that
+/	wants the time of flight or the lead reads them from here.
+/ ----------------------------------------------------------------------------*/
+#ifndef SOLUTION_H
+#define SOLUTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ballistics.h"
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	uint64_t sampleUs;		// When the accelerometer was read
+	short distance_cm;		// LIDAR_DC when disconnected
+	bool isLocked;
+	double elev_deg;
+	double cant_deg;
+	int xOffset;			// Pixels from the center, 0 without a range
+	int zOffset;
+	BallisticsSolution ballistics;	// All 0 without a range
+} Solution;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Publishes a new solution, only one core may call this
+void Solution_publish(const Solution *solution);
+
+// Copies the newest solution, never blocks the publisher
+// Returns its sequence number, which counts up from 1, or 0 if none yet
+uint32_t Solution_read(Solution *solution);
+
+#endif
@@ -0,0 +1,137 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - trace.c															   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the binary trace queue.
+/
+/	Trace_record() copies a record into a ring of QUEUE_SIZE bytes and
+/	Trace_drain() hands the ring to the USB port a piece at a time, as much
+/	as its TX buffer has room for. The sensor capture (capture.c) queues
+/	its packets with Trace_send() in the same ring, so they take turns on
+/	the port whole. Everything runs on core 0 from the scheduler, so the
+/	ring needs no locking. When the host isn't reading fast enough the
+/	newest records are dropped, and the next record that fits carries the
+/	count.
+/	The text that is still printed shares the port, so a record starts
+/	with two sync bytes that never appear in text and carries a checksum,
+/	which lets the decoder find records between the lines.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <string.h>
+#include "hal.h"
+#include "trace.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// About a second of records, or half a second of them with the capture on,
+// must be a power of 2
+#define QUEUE_SIZE 4096
+#define QUEUE_MASK (QUEUE_SIZE - 1)
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+static uint8_t queue[QUEUE_SIZE];
+static uint32_t queueHead = 0;
+static uint32_t queueTail = 0;
+
+static uint8_t sequence = 0;
+static uint32_t numDropped = 0;
+static uint32_t numDroppedSince = 0;	// Since the last queued record
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static uint8_t checksum(const TraceRecord *record)
+{
+	const uint8_t *bytes = (const uint8_t *)record;
+	uint8_t sum = 0;
+
+	for (size_t i = 2; i < sizeof(TraceRecord); i++) {
+		sum += bytes[i];
+	}
+	return sum;
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+bool Trace_record(TraceRecord *record)
+{
+	record->sync[0] = TRACE_SYNC0;
+	record->sync[1] = TRACE_SYNC1;
+	record->sequence = sequence++;
+
+	if (QUEUE_SIZE - (queueHead - queueTail) < sizeof(TraceRecord)) {
+		numDropped++;
+		numDroppedSince++;
+		return false;
+	}
+
+	record->numDropped = numDroppedSince > UINT16_MAX ? UINT16_MAX
+			: (uint16_t)numDroppedSince;
+	record->checksum = 0;
+	record->checksum = (uint8_t)-checksum(record);
+
+	Trace_send((const uint8_t *)record, sizeof(TraceRecord));
+	numDroppedSince = 0;
+	return true;
+}
+
+bool Trace_send(const uint8_t *bytes, size_t len)
+{
+	uint32_t head = queueHead & QUEUE_MASK;
+	size_t first = QUEUE_SIZE - head;
+
+	if (QUEUE_SIZE - (queueHead - queueTail) < len) {
+		return false;
+	}
+
+	if (first > len)
+		first = len;
+	memcpy(&queue[head], bytes, first);
+	memcpy(queue, bytes + first, len - first);
+	queueHead += len;
+	return true;
+}
+
+void Trace_drain()
+{
+	while (queueTail != queueHead) {
+		uint32_t tail = queueTail & QUEUE_MASK;
+		size_t len = queueHead - queueTail;
+		size_t taken;
+
+		// Up to the end of the ring, the rest goes on the next pass
+		if (len > QUEUE_SIZE - tail)
+			len = QUEUE_SIZE - tail;
+
+		taken = Hal_serialWrite(&queue[tail], len);
+		queueTail += taken;
+		if (taken < len) {
+			return;
+		}
+	}
+}
+
+uint32_t Trace_getDroppedCount()
+{
+	return numDropped;
+}
+
+uint16_t Trace_clampUs(uint32_t us)
+{
+	return us > UINT16_MAX ? UINT16_MAX : (uint16_t)us;
+}
@@ -0,0 +1,93 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - trace.h															   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the binary trace.
+/	Each display frame makes one fixed size record that is queued in RAM
+/	and sent over USB in the background, so nothing is formatted on the
+/	hot path. host/trace_decode.c turns the stream back into CSV.
+/ ----------------------------------------------------------------------------*/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// 1 sends the per frame telemetry as trace records, 0 prints it as text
+#define TRACE 1
+
+// Neither is ever in the text printed on the same port
+#define TRACE_SYNC0 0xA5
+#define TRACE_SYNC1 0xFE
+
+#define TRACE_RECORD_SIZE 44
+
+#define TRACE_FLAG_LOCKED (1 << 0)
+
+typedef enum {
+	TRACE_STAGE_ACCEL,			// Accelerometer task
+	TRACE_STAGE_LIDAR,			// LIDAR task
+	TRACE_STAGE_BALLISTICS,		// Ballistics_poll() and the pixel offset
+	TRACE_STAGE_DISPLAY,		// The previous display task, all of it
+	TRACE_NUM_STAGES
+} TraceStage;
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+// Little endian on both the RP2040 and the host, every field is aligned
+// so there is no padding
+typedef struct {
+	uint8_t sync[2];
+	uint8_t sequence;			// Counts every record made, sent or not
+	uint8_t checksum;			// The bytes after sync add up to 0
+	uint32_t timeUs;			// When the record was made
+	uint32_t sampleUs;			// When the accelerometer sample was read
+	int16_t accel[3];			// Newest raw sample, 256 counts per g
+	int16_t distance_cm;		// Filtered, -1 when disconnected
+	int16_t rawDistance_cm;		// Newest LIDAR frame
+	uint16_t strength;			// Of the newest LIDAR frame
+	int16_t elev_cdeg;			// Hundredths of a degree
+	int16_t cant_cdeg;
+	int16_t xOffset;			// Pixels from the center
+	int16_t zOffset;
+	uint16_t stageUs[TRACE_NUM_STAGES];	// Run times, 65535 for longer
+	uint8_t confidence;			// Of the range, 0 - 100 %
+	uint8_t flags;				// TRACE_FLAG_*
+	uint16_t numDropped;		// Records lost to a full queue before this one
+} TraceRecord;
+
+_Static_assert(sizeof(TraceRecord) == TRACE_RECORD_SIZE, "TraceRecord has padding");
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Fills in the sync, sequence, checksum and drop count and queues a copy
+// Returns false if the queue was full and the record was dropped
+bool Trace_record(TraceRecord *record);
+
+// Queues bytes for the port whole or not at all, for other binary streams
+// that share it (capture.c)
+// Returns false if there wasn't room
+bool Trace_send(const uint8_t *bytes, size_t len);
+
+// Sends as much of the queue as the USB port takes, never blocks
+void Trace_drain();
+
+// Records dropped since setup
+uint32_t Trace_getDroppedCount();
+
+// Saturates a run time for TraceRecord.stageUs
+uint16_t Trace_clampUs(uint32_t us);
+
+#endif
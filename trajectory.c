@@ -0,0 +1,398 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - trajectory.c													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the drag trajectory solver.
+/
+/	The retardation of a G model bullet is
+/		a = rho * Cd(mach) * v^2 * pi / (8 * BC)
+/	with BC in kg/m^2 and Cd from the standard G1 or G7 table. The state is
+/	integrated with fixed step RK4 in float, which is plenty for a few
+/	hundred metres and roughly twice as fast as double in soft float.
+/	Whenever a step crosses a whole metre the time, drop and speed are
+/	interpolated into the range table, stored in Q16.16 so the fixed
+/	ballistics path can look it up without floating point.
+/
+/	The table is built into a spare copy, a slice of steps at a time with
+/	Trajectory_continue(), and swapped in once it is complete, so a new
+/	load can be integrated over several frames while the old table stays
+/	in use.
+/ ----------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------*/
+/* Include Files												*/
+/*--------------------------------------------------------------*/
+
+#include <math.h>
+#include "trajectory.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+#define TABLE_SIZE (TRAJECTORY_MAX_DIST_M + 1)
+
+#define STEP_S 0.002f
+#define MAX_TIME_S 20.0f
+
+#define GRAVITY 9.8f				// m/s^2
+#define AIR_DENSITY 1.225f			// kg/m^3, ICAO sea level
+#define SPEED_OF_SOUND 340.3f		// m/s, ICAO sea level
+#define LB_PER_IN2_TO_KG_PER_M2 703.0696f
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	float mach, cd;
+} DragPoint;
+
+typedef struct {
+	const DragPoint *table;
+	int size;
+	float k;			// rho * pi / (8 * BC)
+} Drag;
+
+// x down range along the bore, y up
+typedef struct {
+	float x, y, vx, vy;
+} State;
+
+typedef struct {
+	fix16 time, drop;
+	fix16 velocity;
+} RangeEntry;
+
+// Where Trajectory_continue() left off
+typedef struct {
+	Drag drag;
+	State s;
+	int steps;
+	int next;					// Next metre of buildTable
+	bool isBuilding;
+} Builder;
+
+/*--------------------------------------------------------------*/
+/* Global Variables				 								*/
+/*--------------------------------------------------------------*/
+
+// Standard drag functions, Cd against mach
+static const DragPoint g1Table[] = {
+	{0.00f, 0.2629f}, {0.05f, 0.2558f}, {0.10f, 0.2487f}, {0.15f, 0.2413f},
+	{0.20f, 0.2344f}, {0.25f, 0.2278f}, {0.30f, 0.2214f}, {0.35f, 0.2155f},
+	{0.40f, 0.2104f}, {0.45f, 0.2061f}, {0.50f, 0.2032f}, {0.55f, 0.2020f},
+	{0.60f, 0.2034f}, {0.70f, 0.2165f}, {0.725f, 0.2230f}, {0.75f, 0.2313f},
+	{0.775f, 0.2417f}, {0.80f, 0.2546f}, {0.825f, 0.2706f}, {0.85f, 0.2901f},
+	{0.875f, 0.3136f}, {0.90f, 0.3415f}, {0.925f, 0.3734f}, {0.95f, 0.4084f},
+	{0.975f, 0.4448f}, {1.00f, 0.4805f}, {1.025f, 0.5136f}, {1.05f, 0.5427f},
+	{1.075f, 0.5677f}, {1.10f, 0.5883f}, {1.125f, 0.6053f}, {1.15f, 0.6191f},
+	{1.20f, 0.6393f}, {1.25f, 0.6518f}, {1.30f, 0.6589f}, {1.35f, 0.6621f},
+	{1.40f, 0.6625f}, {1.45f, 0.6607f}, {1.50f, 0.6573f}, {1.55f, 0.6528f},
+	{1.60f, 0.6474f}, {1.65f, 0.6413f}, {1.70f, 0.6347f}, {1.75f, 0.6280f},
+	{1.80f, 0.6210f}, {1.85f, 0.6141f}, {1.90f, 0.6072f}, {1.95f, 0.6003f},
+	{2.00f, 0.5934f}, {2.05f, 0.5867f}, {2.10f, 0.5804f}, {2.15f, 0.5743f},
+	{2.20f, 0.5685f}, {2.25f, 0.5630f}, {2.30f, 0.5577f}, {2.35f, 0.5527f},
+	{2.40f, 0.5481f}, {2.45f, 0.5438f}, {2.50f, 0.5397f}, {2.60f, 0.5325f},
+	{2.70f, 0.5264f}, {2.80f, 0.5211f}, {2.90f, 0.5168f}, {3.00f, 0.5133f},
+	{3.10f, 0.5105f}, {3.20f, 0.5084f}, {3.30f, 0.5067f}, {3.40f, 0.5054f},
+	{3.50f, 0.5040f}, {3.60f, 0.5030f}, {3.70f, 0.5022f}, {3.80f, 0.5016f},
+	{3.90f, 0.5010f}, {4.00f, 0.5006f}, {4.20f, 0.4998f}, {4.40f, 0.4995f},
+	{4.60f, 0.4992f}, {4.80f, 0.4990f}, {5.00f, 0.4988f}
+};
+
+static const DragPoint g7Table[] = {
+	{0.00f, 0.1198f}, {0.05f, 0.1197f}, {0.10f, 0.1196f}, {0.15f, 0.1194f},
+	{0.20f, 0.1193f}, {0.25f, 0.1194f}, {0.30f, 0.1194f}, {0.35f, 0.1194f},
+	{0.40f, 0.1193f}, {0.45f, 0.1193f}, {0.50f, 0.1194f}, {0.55f, 0.1193f},
+	{0.60f, 0.1194f}, {0.65f, 0.1197f}, {0.70f, 0.1202f}, {0.725f, 0.1207f},
+	{0.75f, 0.1215f}, {0.775f, 0.1226f}, {0.80f, 0.1242f}, {0.825f, 0.1266f},
+	{0.85f, 0.1306f}, {0.875f, 0.1368f}, {0.90f, 0.1464f}, {0.925f, 0.1660f},
+	{0.95f, 0.2054f}, {0.975f, 0.2993f}, {1.00f, 0.3803f}, {1.025f, 0.4015f},
+	{1.05f, 0.4043f}, {1.075f, 0.4034f}, {1.10f, 0.4014f}, {1.125f, 0.3987f},
+	{1.15f, 0.3955f}, {1.20f, 0.3884f}, {1.25f, 0.3810f}, {1.30f, 0.3732f},
+	{1.35f, 0.3657f}, {1.40f, 0.3580f}, {1.50f, 0.3440f}, {1.55f, 0.3376f},
+	{1.60f, 0.3315f}, {1.65f, 0.3260f}, {1.70f, 0.3209f}, {1.75f, 0.3160f},
+	{1.80f, 0.3117f}, {1.85f, 0.3078f}, {1.90f, 0.3042f}, {1.95f, 0.3010f},
+	{2.00f, 0.2980f}, {2.05f, 0.2951f}, {2.10f, 0.2922f}, {2.15f, 0.2892f},
+	{2.20f, 0.2864f}, {2.25f, 0.2835f}, {2.30f, 0.2807f}, {2.35f, 0.2779f},
+	{2.40f, 0.2752f}, {2.45f, 0.2725f}, {2.50f, 0.2697f}, {2.55f, 0.2670f},
+	{2.60f, 0.2643f}, {2.65f, 0.2615f}, {2.70f, 0.2588f}, {2.75f, 0.2561f},
+	{2.80f, 0.2533f}, {2.85f, 0.2506f}, {2.90f, 0.2479f}, {2.95f, 0.2451f},
+	{3.00f, 0.2424f}, {3.10f, 0.2368f}, {3.20f, 0.2313f}, {3.30f, 0.2258f},
+	{3.40f, 0.2205f}, {3.50f, 0.2154f}, {3.60f, 0.2106f}, {3.70f, 0.2060f},
+	{3.80f, 0.2017f}, {3.90f, 0.1975f}, {4.00f, 0.1935f}, {4.20f, 0.1861f},
+	{4.40f, 0.1793f}, {4.60f, 0.1730f}, {4.80f, 0.1672f}, {5.00f, 0.1618f}
+};
+
+// One table is looked up while the other is built
+static RangeEntry tables[2][TABLE_SIZE];
+static RangeEntry *rangeTable = tables[0];
+static RangeEntry *buildTable = tables[1];
+static Builder build = {.isBuilding = false};
+
+/*--------------------------------------------------------------*/
+/*  Static Function Implemetations								*/
+/*--------------------------------------------------------------*/
+
+static Drag getDrag(const AmmoLoad *load)
+{
+	Drag drag;
+
+	if (load->dragModel == DRAG_G7) {
+		drag.table = g7Table;
+		drag.size = sizeof(g7Table) / sizeof(g7Table[0]);
+	} else {
+		drag.table = g1Table;
+		drag.size = sizeof(g1Table) / sizeof(g1Table[0]);
+	}
+
+	if (load->ballisticCoefficient > 0) {
+		drag.k = AIR_DENSITY * (float)M_PI
+				/ (8 * load->ballisticCoefficient * LB_PER_IN2_TO_KG_PER_M2);
+	} else {
+		drag.k = 0;
+	}
+
+	return drag;
+}
+
+// Cd at a mach number, clamped to the ends of the table
+static float dragCoefficient(const Drag *drag, float mach)
+{
+	const DragPoint *table = drag->table;
+	int low = 0;
+	int high = drag->size - 1;
+
+	if (mach <= table[low].mach)
+		return table[low].cd;
+	if (mach >= table[high].mach)
+		return table[high].cd;
+
+	// table[low].mach <= mach < table[high].mach
+	while (high - low > 1) {
+		int mid = (low + high) / 2;
+
+		if (table[mid].mach <= mach) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+
+	float u = (mach - table[low].mach) / (table[high].mach - table[low].mach);
+	return table[low].cd + u * (table[high].cd - table[low].cd);
+}
+
+static State derivative(const Drag *drag, const State *s)
+{
+	State d;
+	float v = sqrtf(s->vx * s->vx + s->vy * s->vy);
+	float a = 0;
+
+	if (drag->k > 0) {
+		a = drag->k * dragCoefficient(drag, v / SPEED_OF_SOUND) * v;
+	}
+
+	d.x = s->vx;
+	d.y = s->vy;
+	d.vx = -a * s->vx;
+	d.vy = -a * s->vy - GRAVITY;
+
+	return d;
+}
+
+// s + k * h
+static State advance(const State *s, const State *k, float h)
+{
+	State result = {
+		s->x + k->x * h,
+		s->y + k->y * h,
+		s->vx + k->vx * h,
+		s->vy + k->vy * h
+	};
+	return result;
+}
+
+static void rk4Step(const Drag *drag, State *s, float dt)
+{
+	State k1 = derivative(drag, s);
+	State s2 = advance(s, &k1, dt / 2);
+	State k2 = derivative(drag, &s2);
+	State s3 = advance(s, &k2, dt / 2);
+	State k3 = derivative(drag, &s3);
+	State s4 = advance(s, &k3, dt);
+	State k4 = derivative(drag, &s4);
+
+	s->x += dt / 6 * (k1.x + 2 * k2.x + 2 * k3.x + k4.x);
+	s->y += dt / 6 * (k1.y + 2 * k2.y + 2 * k3.y + k4.y);
+	s->vx += dt / 6 * (k1.vx + 2 * k2.vx + 2 * k3.vx + k4.vx);
+	s->vy += dt / 6 * (k1.vy + 2 * k2.vy + 2 * k3.vy + k4.vy);
+}
+
+/*--------------------------------------------------------------*/
+/*  Function Implemetations										*/
+/*--------------------------------------------------------------*/
+
+int Trajectory_setup(const AmmoLoad *load)
+{
+	Trajectory_begin(load);
+	while (!Trajectory_continue(INT32_MAX)) {
+	}
+
+	return build.steps;
+}
+
+void Trajectory_begin(const AmmoLoad *load)
+{
+	RangeEntry *table = buildTable;
+
+	build.drag = getDrag(load);
+	build.s.x = 0;
+	build.s.y = 0;
+	build.s.vx = load->muzzleVelocity;
+	build.s.vy = 0;
+	build.steps = 0;
+	build.next = 1;
+	build.isBuilding = true;
+
+	table[0].time = 0;
+	table[0].drop = 0;
+	table[0].velocity = Fix16_fromDouble(load->muzzleVelocity);
+}
+
+bool Trajectory_continue(int maxSteps)
+{
+	RangeEntry *table = buildTable;
+	State *s = &build.s;
+	int next = build.next;
+
+	if (!build.isBuilding) {
+		return true;
+	}
+
+	for (int i = 0; i < maxSteps && next < TABLE_SIZE && build.steps * STEP_S < MAX_TIME_S; i++) {
+		State prev = *s;
+		float prevSpeed = sqrtf(s->vx * s->vx + s->vy * s->vy);
+
+		rk4Step(&build.drag, s, STEP_S);
+		build.steps++;
+		float speed = sqrtf(s->vx * s->vx + s->vy * s->vy);
+
+		// Sample every whole metre crossed by this step
+		while (next < TABLE_SIZE && s->x >= next) {
+			float u = (next - prev.x) / (s->x - prev.x);
+
+			table[next].time = Fix16_fromDouble((build.steps - 1 + u) * STEP_S);
+			table[next].drop = Fix16_fromDouble(-(prev.y + u * (s->y - prev.y)));
+			table[next].velocity = Fix16_fromDouble(prevSpeed + u * (speed - prevSpeed));
+			next++;
+		}
+	}
+
+	build.next = next;
+	if (next < TABLE_SIZE && build.steps * STEP_S < MAX_TIME_S) {
+		return false;
+	}
+
+	// Never got a metre out, there is no trajectory to extrapolate
+	if (next < 2) {
+		for (; next < TABLE_SIZE; next++) {
+			table[next].time = FIX16_MAX;
+			table[next].drop = FIX16_MAX;
+			table[next].velocity = 0;
+		}
+	}
+
+	// Ran out of time, continue the last slope
+	for (; next < TABLE_SIZE; next++) {
+		table[next].time = 2 * table[next - 1].time - table[next - 2].time;
+		table[next].drop = 2 * table[next - 1].drop - table[next - 2].drop;
+		table[next].velocity = table[next - 1].velocity;
+	}
+
+	// Lookups move over to the new table in one go
+	buildTable = rangeTable;
+	rangeTable = table;
+	build.isBuilding = false;
+	return true;
+}
+
+void Trajectory_lookup(double distance_m, double *time_s, double *drop_m)
+{
+	int i = (int)distance_m;
+
+	if (distance_m < 0)
+		i = 0;
+	if (i > TABLE_SIZE - 2)
+		i = TABLE_SIZE - 2;
+
+	double u = distance_m - i;
+	const RangeEntry *e0 = &rangeTable[i];
+	const RangeEntry *e1 = &rangeTable[i + 1];
+
+	*time_s = Fix16_toDouble(e0->time) + u * Fix16_toDouble(e1->time - e0->time);
+	*drop_m = Fix16_toDouble(e0->drop) + u * Fix16_toDouble(e1->drop - e0->drop);
+}
+
+void Trajectory_lookupFixed(fix16 distance_m, fix16 *time_s, fix16 *drop_m)
+{
+	int i = distance_m >> 16;
+
+	if (distance_m < 0)
+		i = 0;
+	if (i > TABLE_SIZE - 2)
+		i = TABLE_SIZE - 2;
+
+	fix16 u = distance_m - Fix16_fromInt(i);
+	const RangeEntry *e0 = &rangeTable[i];
+	const RangeEntry *e1 = &rangeTable[i + 1];
+
+	*time_s = e0->time + Fix16_mul(e1->time - e0->time, u);
+	*drop_m = e0->drop + Fix16_mul(e1->drop - e0->drop, u);
+}
+
+double Trajectory_lookupVelocity(double distance_m)
+{
+	int i = (int)distance_m;
+
+	if (distance_m < 0)
+		i = 0;
+	if (i > TABLE_SIZE - 2)
+		i = TABLE_SIZE - 2;
+
+	double u = distance_m - i;
+	const RangeEntry *e0 = &rangeTable[i];
+	const RangeEntry *e1 = &rangeTable[i + 1];
+
+	return Fix16_toDouble(e0->velocity) + u * Fix16_toDouble(e1->velocity - e0->velocity);
+}
+
+int Trajectory_solve(const AmmoLoad *load, double distance_m, double *time_s, double *drop_m)
+{
+	Drag drag = getDrag(load);
+	State s = {0, 0, load->muzzleVelocity, 0};
+	State prev = s;
+	int steps = 0;
+
+	while (s.x < distance_m && steps * STEP_S < MAX_TIME_S) {
+		prev = s;
+		rk4Step(&drag, &s, STEP_S);
+		steps++;
+	}
+
+	if (steps == 0) {
+		*time_s = 0;
+		*drop_m = 0;
+		return 0;
+	}
+
+	float u = ((float)distance_m - prev.x) / (s.x - prev.x);
+	*time_s = (steps - 1 + u) * STEP_S;
+	*drop_m = -(prev.y + u * (s.y - prev.y));
+
+	return steps;
+}
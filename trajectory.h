@@ -0,0 +1,72 @@
+/*---------------------------------------------------------------------------- /
+/	IFOBS - trajectory.h													   /
+/ ---------------------------------------------------------------------------- /
+/	Bowie Gian
+/	Created: 2026-10-17
+/	Modified: 2026-10-17
+/
+/	This file contains the function declarations for the drag trajectory
+/	solver. A point mass trajectory is integrated with RK4 against the
+/	standard G1 or G7 drag table and the load's ballistic coefficient, and
+/	sampled into a dense range table that the ballistics paths look up
+/	every frame.
+/
+/	Distances are along the bore and the drop is the vertical distance
+/	below the bore line, for a level shot.
+/ ----------------------------------------------------------------------------*/
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <stdbool.h>
+#include "fixmath.h"
+
+/*--------------------------------------------------------------*/
+/* Definitions													*/
+/*--------------------------------------------------------------*/
+
+// Range table, 1 m apart, linearly extrapolated past the end
+#define TRAJECTORY_MAX_DIST_M 500
+
+typedef enum {
+	DRAG_G1,		// Flat base
+	DRAG_G7			// Boat tail
+} DragModel;
+
+/*--------------------------------------------------------------*/
+/* Structs														*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+	float muzzleVelocity;			// m/s
+	float ballisticCoefficient;		// lb/in^2 for the drag model, 0 for no drag
+	DragModel dragModel;
+} AmmoLoad;
+
+/*--------------------------------------------------------------*/
+/* Function Prototypes	    									*/
+/*--------------------------------------------------------------*/
+
+// Integrates the load and builds the range table
+// Call at boot and whenever the load changes, returns the RK4 step count
+// A load that never gets 1 m out reads FIX16_MAX time and drop past 0 m
+int Trajectory_setup(const AmmoLoad *load);
+
+// The same spread out: begin starts integrating the load into a spare
+// table, and each continue runs at most maxSteps RK4 steps of it. Returns
+// true once the new table has replaced the old one, which is looked up
+// until then
+void Trajectory_begin(const AmmoLoad *load);
+bool Trajectory_continue(int maxSteps);
+
+// Time of flight and drop at a distance, interpolated from the range table
+void Trajectory_lookup(double distance_m, double *time_s, double *drop_m);
+void Trajectory_lookupFixed(fix16 distance_m, fix16 *time_s, fix16 *drop_m);
+
+// Speed of the bullet at a distance in m/s, from the same table
+double Trajectory_lookupVelocity(double distance_m);
+
+// Integrates the load directly to a distance, for checking the table
+// Returns the RK4 step count
+int Trajectory_solve(const AmmoLoad *load, double distance_m, double *time_s, double *drop_m);
+
+#endif